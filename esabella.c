@@ -1,1954 +1,9100 @@
-#include <stdio.h>
-#include <string.h>
-#ifdef WIN64
-#include <windows.h>
-#else
-#include <sys/time.h>
-#endif
-
-#define u64 unsigned long long
-
-// FEN debug positions
-#define empty_board "8/8/8/8/8/8/8/8 w - - "
-#define start_position "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 "
-#define tricky_position "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 "
-#define killer_position "rnbqkb1r/pp1p1pPp/8/2p1pP2/1P1P4/3P3P/P1P1P3/RNBQKBNR w KQkq e6 0 1"
-#define cmk_position "r2q1rk1/ppp2ppp/2n1bn2/2b1p3/3pP3/3P1NPP/PPP1NPB1/R1BQ1RK1 b - - 0 9 "
-
-#define get_bit(bitboard, square) ((bitboard) & (1ULL << (square)))
-#define set_bit(bitboard, square) ((bitboard) |= (1ULL << (square)))
-#define pop_bit(bitboard, square) ((bitboard) &= (~(1ULL << (square))))
-static inline int count_bits(u64 bitboard)
-{
-  // int count = 0;
-  // while (bitboard)
-  // {
-  //     bitboard &= bitboard - 1;
-  //     count++;
-  // }
-
-  // return count;
-
-  return __builtin_popcountll(bitboard);
-}
-static inline int get_lsb1st_index(u64 bitboard)
-{
-  // if (bitboard)
-  // {
-  //     return count_bits((bitboard & -bitboard) - 1);
-  // }
-  // else
-  // {
-  //     return -1;
-  // }
-
-  if (bitboard == 0)
-  {
-    return -1;
-  }
-
-  return __builtin_ctzll(bitboard);
-}
-
-// board squares
-enum
-{
-  a8,
-  b8,
-  c8,
-  d8,
-  e8,
-  f8,
-  g8,
-  h8,
-  a7,
-  b7,
-  c7,
-  d7,
-  e7,
-  f7,
-  g7,
-  h7,
-  a6,
-  b6,
-  c6,
-  d6,
-  e6,
-  f6,
-  g6,
-  h6,
-  a5,
-  b5,
-  c5,
-  d5,
-  e5,
-  f5,
-  g5,
-  h5,
-  a4,
-  b4,
-  c4,
-  d4,
-  e4,
-  f4,
-  g4,
-  h4,
-  a3,
-  b3,
-  c3,
-  d3,
-  e3,
-  f3,
-  g3,
-  h3,
-  a2,
-  b2,
-  c2,
-  d2,
-  e2,
-  f2,
-  g2,
-  h2,
-  a1,
-  b1,
-  c1,
-  d1,
-  e1,
-  f1,
-  g1,
-  h1,
-  no_sq
-};
-
-// sides to move
-enum
-{
-  white,
-  black,
-  both
-};
-
-// encode pieces
-enum
-{
-  P,
-  N,
-  B,
-  R,
-  Q,
-  K,
-  p,
-  n,
-  b,
-  r,
-  q,
-  k
-};
-
-// bishop and rook
-enum
-{
-  rook,
-  bishop
-};
-
-// castling bits binary representation
-/*
- *    bin     dec
- *    0001    1       white king castle to the king side
- *    0010    2       white king castle to the queen side
- *    0100    4       black king castle to the king side
- *    1000    8       black king castle to the queen side
- */
-
-enum
-{
-  wk = 1,
-  wq = 2,
-  bk = 4,
-  bq = 8
-};
-
-const char *square_to_coordinates[] = {
-    "A8", "B8", "C8", "D8", "E8", "F8", "G8", "H8",
-    "A7", "B7", "C7", "D7", "E7", "F7", "G7", "H7",
-    "A6", "B6", "C6", "D6", "E6", "F6", "G6", "H6",
-    "A5", "B5", "C5", "D5", "E5", "F5", "G5", "H5",
-    "A4", "B4", "C4", "D4", "E4", "F4", "G4", "H4",
-    "A3", "B3", "C3", "D3", "E3", "F3", "G3", "H3",
-    "A2", "B2", "C2", "D2", "E2", "F2", "G2", "H2",
-    "A1", "B1", "C1", "D1", "E1", "F1", "G1", "H1"};
-
-// ascii pieces
-char ascii_pieces[12] = "PNBRQKpnbrqk";
-
-// unicode pieces
-char *unicode_pieces[12] = {"♙", "♘", "♗", "♖", "♕", "♔", "♟", "♞", "♝", "♜", "♛", "♚"};
-
-// convert ascii character peices to encoded constants
-int char_pieces[] = {
-    ['P'] = P,
-    ['N'] = N,
-    ['B'] = B,
-    ['R'] = R,
-    ['Q'] = Q,
-    ['K'] = K,
-    ['p'] = p,
-    ['n'] = n,
-    ['b'] = b,
-    ['r'] = r,
-    ['q'] = q,
-    ['k'] = k};
-
-// promoted pieces
-char promoted_pieces[] = {
-    [Q] = 'q',
-    [R] = 'r',
-    [B] = 'b',
-    [N] = 'n',
-    [q] = 'q',
-    [r] = 'r',
-    [b] = 'b',
-    [n] = 'n'};
-
-void print_bitboard(u64 bitboard)
-{
-  printf("\n");
-  for (int rank = 0; rank < 8; rank++)
-  {
-    for (int file = 0; file < 8; file++)
-    {
-      if (file == 0)
-      {
-        printf("  %d  ", 8 - rank);
-      }
-      int square = rank * 8 + file;
-      printf("%d ", get_bit(bitboard, square) ? 1 : 0);
-    }
-    printf("\n");
-  }
-  printf("\n     A B C D E F G H \n");
-  printf("\n     Bitboard: %llud\n", bitboard);
-}
-
-// piece bitboards
-u64 bitboards[12];
-
-// occupancy bitboards
-u64 occupancies[3];
-
-// side to move
-int side = 0;
-
-// enpassant square
-int enpassant = no_sq;
-
-// castling rights
-int castle;
-
-// pseudo random number state
-unsigned int random_state = 1804289383;
-
-// generate 32 bit pseudo legal numbers
-unsigned int get_random_u32_number()
-{
-  // get current random_state
-  unsigned int number = random_state;
-
-  // XOR shift algorithm
-  number ^= (number << 13);
-  number ^= (number >> 17);
-  number ^= (number << 5);
-
-  // update random number random_state
-  random_state = number;
-
-  return number;
-}
-
-// generate 64 bit pseudo legal numbers
-u64 get_random_u64_number()
-{
-  // define 4 random numbers
-  u64 n1, n2, n3, n4;
-
-  // init random numbers slicing 16 bits from MS1B side
-  n1 = (u64)(get_random_u32_number()) & 0xFFFF;
-  n2 = (u64)(get_random_u32_number()) & 0xFFFF;
-  n3 = (u64)(get_random_u32_number()) & 0xFFFF;
-  n4 = (u64)(get_random_u32_number()) & 0xFFFF;
-
-  return n1 | (n2 << 16) | (n3 << 32) | (n4 << 48);
-}
-
-// generate magic number candidate
-u64 generate_magic_number()
-{
-  return get_random_u64_number() & get_random_u64_number() & get_random_u64_number();
-}
-
-void print_board()
-{
-  printf("\n");
-  for (int rank = 0; rank < 8; rank++)
-  {
-    for (int file = 0; file < 8; file++)
-    {
-      int square = rank * 8 + file;
-      if (!file)
-        printf("  %d  ", 8 - rank);
-
-      int piece = -1;
-      // loop over all piece bitboard
-      for (int bb_piece = P; bb_piece <= k; bb_piece++)
-      {
-        if (get_bit(bitboards[bb_piece], square))
-        {
-          piece = bb_piece;
-        }
-      }
-#ifdef WIN64
-      printf("%c ", (piece == -1) ? '.' : ascii_pieces[piece]);
-#else
-      printf("%s ", (piece == -1) ? "." : unicode_pieces[piece]);
-#endif
-    }
-    printf("\n");
-  }
-  printf("\n     A B C D E F G H \n\n");
-
-  printf("     Side to move  :    %s\n", (!side) ? "white" : "black");
-  printf("     Enpassant     :    %s\n", (enpassant != no_sq) ? square_to_coordinates[enpassant] : "no");
-  printf("     Castling      :    %c%c%c%c\n\n", (castle & wk) ? 'K' : '-', (castle & wq) ? 'Q' : '-', (castle & bk) ? 'k' : '-', (castle & bq) ? 'q' : '-');
-}
-
-// Parsing FEN string
-void parse_fen(char *fen)
-{
-  // reset the position (bitboards)
-  memset(bitboards, 0ULL, sizeof(bitboards));
-  // reset the occupancies (bitboards)
-  memset(occupancies, 0ULL, sizeof(occupancies));
-  // reset game state variables
-  side = 0;
-  enpassant = no_sq;
-  castle = 0;
-
-  for (int rank = 0; rank < 8; rank++)
-  {
-    for (int file = 0; file < 8; file++)
-    {
-      int square = rank * 8 + file;
-
-      // matching ascii pieces of FEN string
-      if ((*fen >= 'a' && *fen <= 'z') || *fen >= 'A' && *fen <= 'Z')
-      {
-        int piece = char_pieces[*fen];
-        set_bit(bitboards[piece], square);
-        fen++;
-      }
-      // matching empty square nunmber within FEN string
-      if (*fen >= '0' && *fen <= '9')
-      {
-        int offset = *fen - '0';
-
-        // on empty currrent square we want to decrement a file
-        int piece = -1;
-        for (int bb_piece = P; bb_piece <= k; bb_piece++)
-        {
-          if (get_bit(bitboards[bb_piece], square))
-            piece = bb_piece;
-        }
-
-        if (piece == -1)
-        {
-          file--;
-        }
-
-        file += offset;
-        fen++;
-      }
-      // matching rank separater
-      if (*fen == '/')
-      {
-        fen++;
-      }
-    }
-  }
-
-  // go to parse side to move
-  fen++;
-  (*fen == 'w') ? (side = white) : (side = black);
-
-  // go to parse castling rights
-  fen += 2;
-  while (*fen != ' ')
-  {
-    switch (*fen)
-    {
-    case 'K':
-      castle |= wk;
-      break;
-    case 'Q':
-      castle |= wq;
-      break;
-    case 'k':
-      castle |= bk;
-      break;
-    case 'q':
-      castle |= bq;
-      break;
-    case '-':
-      break;
-    }
-    fen++;
-  }
-
-  // go to parse enpassent square
-  fen++;
-  if (*fen != '-')
-  {
-    int file = fen[0] - 'a';
-    int rank = 8 - (fen[1] - '0');
-
-    enpassant = rank * 8 + file;
-  }
-  else
-  {
-    enpassant = no_sq;
-  }
-
-  for (int piece = P; piece <= K; piece++)
-  {
-    // populate white occupancies
-    occupancies[white] |= bitboards[piece];
-  }
-  for (int piece = p; piece <= k; piece++)
-  {
-    // populate black occupancies
-    occupancies[black] |= bitboards[piece];
-  }
-
-  occupancies[both] |= occupancies[white];
-  occupancies[both] |= occupancies[black];
-}
-
-// not A file
-/*
- * 8   0 1 1 1 1 1 1 1
- * 7   0 1 1 1 1 1 1 1
- * 6   0 1 1 1 1 1 1 1
- * 5   0 1 1 1 1 1 1 1
- * 4   0 1 1 1 1 1 1 1
- * 3   0 1 1 1 1 1 1 1
- * 2   0 1 1 1 1 1 1 1
- * 1   0 1 1 1 1 1 1 1
- *
- *    A B C D E F G H
- */
-const u64 not_a_file = 18374403900871474942ULL;
-
-// not H file
-/*
- * 8   1 1 1 1 1 1 1 0
- * 7   1 1 1 1 1 1 1 0
- * 6   1 1 1 1 1 1 1 0
- * 5   1 1 1 1 1 1 1 0
- * 4   1 1 1 1 1 1 1 0
- * 3   1 1 1 1 1 1 1 0
- * 2   1 1 1 1 1 1 1 0
- * 1   1 1 1 1 1 1 1 0
- *    A B C D E F G H
- */
-const u64 not_h_file = 9187201950435737471ULL;
-
-// not HG file
-/*
- * 8   1 1 1 1 1 1 0 0
- * 7   1 1 1 1 1 1 0 0
- * 6   1 1 1 1 1 1 0 0
- * 5   1 1 1 1 1 1 0 0
- * 4   1 1 1 1 1 1 0 0
- * 3   1 1 1 1 1 1 0 0
- * 2   1 1 1 1 1 1 0 0
- * 1   1 1 1 1 1 1 0 0
- *
- * A B C D E F G H
- */
-const u64 not_hg_file = 4557430888798830399ULL;
-
-// not AB file
-/*
- * 8   0 0 1 1 1 1 1 1
- * 7   0 0 1 1 1 1 1 1
- * 6   0 0 1 1 1 1 1 1
- * 5   0 0 1 1 1 1 1 1
- * 4   0 0 1 1 1 1 1 1
- * 3   0 0 1 1 1 1 1 1
- * 2   0 0 1 1 1 1 1 1
- * 1   0 0 1 1 1 1 1 1
- *
- *    A B C D E F G H
- */
-const u64 not_ab_file = 18229723555195321596ULL;
-
-// bishop relevant ocuupancy bit count for every square on board
-const int bishop_relevant_bits[64] = {
-    6, 5, 5, 5, 5, 5, 5, 6,
-    5, 5, 5, 5, 5, 5, 5, 5,
-    5, 5, 7, 7, 7, 7, 5, 5,
-    5, 5, 7, 9, 9, 7, 5, 5,
-    5, 5, 7, 9, 9, 7, 5, 5,
-    5, 5, 7, 7, 7, 7, 5, 5,
-    5, 5, 5, 5, 5, 5, 5, 5,
-    6, 5, 5, 5, 5, 5, 5, 6};
-
-// rook relevant ocuupancy bit count for every square on board
-const int rook_relevant_bits[64] = {
-    12, 11, 11, 11, 11, 11, 11, 12,
-    11, 10, 10, 10, 10, 10, 10, 11,
-    11, 10, 10, 10, 10, 10, 10, 11,
-    11, 10, 10, 10, 10, 10, 10, 11,
-    11, 10, 10, 10, 10, 10, 10, 11,
-    11, 10, 10, 10, 10, 10, 10, 11,
-    11, 10, 10, 10, 10, 10, 10, 11,
-    12, 11, 11, 11, 11, 11, 11, 12};
-
-// rook magic numbers
-u64 rook_magic_numbers[64] = {
-    0x8a80104000800020ULL,
-    0x140002000100040ULL,
-    0x2801880a0017001ULL,
-    0x100081001000420ULL,
-    0x200020010080420ULL,
-    0x3001c0002010008ULL,
-    0x8480008002000100ULL,
-    0x2080088004402900ULL,
-    0x800098204000ULL,
-    0x2024401000200040ULL,
-    0x100802000801000ULL,
-    0x120800800801000ULL,
-    0x208808088000400ULL,
-    0x2802200800400ULL,
-    0x2200800100020080ULL,
-    0x801000060821100ULL,
-    0x80044006422000ULL,
-    0x100808020004000ULL,
-    0x12108a0010204200ULL,
-    0x140848010000802ULL,
-    0x481828014002800ULL,
-    0x8094004002004100ULL,
-    0x4010040010010802ULL,
-    0x20008806104ULL,
-    0x100400080208000ULL,
-    0x2040002120081000ULL,
-    0x21200680100081ULL,
-    0x20100080080080ULL,
-    0x2000a00200410ULL,
-    0x20080800400ULL,
-    0x80088400100102ULL,
-    0x80004600042881ULL,
-    0x4040008040800020ULL,
-    0x440003000200801ULL,
-    0x4200011004500ULL,
-    0x188020010100100ULL,
-    0x14800401802800ULL,
-    0x2080040080800200ULL,
-    0x124080204001001ULL,
-    0x200046502000484ULL,
-    0x480400080088020ULL,
-    0x1000422010034000ULL,
-    0x30200100110040ULL,
-    0x100021010009ULL,
-    0x2002080100110004ULL,
-    0x202008004008002ULL,
-    0x20020004010100ULL,
-    0x2048440040820001ULL,
-    0x101002200408200ULL,
-    0x40802000401080ULL,
-    0x4008142004410100ULL,
-    0x2060820c0120200ULL,
-    0x1001004080100ULL,
-    0x20c020080040080ULL,
-    0x2935610830022400ULL,
-    0x44440041009200ULL,
-    0x280001040802101ULL,
-    0x2100190040002085ULL,
-    0x80c0084100102001ULL,
-    0x4024081001000421ULL,
-    0x20030a0244872ULL,
-    0x12001008414402ULL,
-    0x2006104900a0804ULL,
-    0x1004081002402ULL};
-
-// bishop magic numbers
-u64 bishop_magic_numbers[64] = {
-    0x40040844404084ULL,
-    0x2004208a004208ULL,
-    0x10190041080202ULL,
-    0x108060845042010ULL,
-    0x581104180800210ULL,
-    0x2112080446200010ULL,
-    0x1080820820060210ULL,
-    0x3c0808410220200ULL,
-    0x4050404440404ULL,
-    0x21001420088ULL,
-    0x24d0080801082102ULL,
-    0x1020a0a020400ULL,
-    0x40308200402ULL,
-    0x4011002100800ULL,
-    0x401484104104005ULL,
-    0x801010402020200ULL,
-    0x400210c3880100ULL,
-    0x404022024108200ULL,
-    0x810018200204102ULL,
-    0x4002801a02003ULL,
-    0x85040820080400ULL,
-    0x810102c808880400ULL,
-    0xe900410884800ULL,
-    0x8002020480840102ULL,
-    0x220200865090201ULL,
-    0x2010100a02021202ULL,
-    0x152048408022401ULL,
-    0x20080002081110ULL,
-    0x4001001021004000ULL,
-    0x800040400a011002ULL,
-    0xe4004081011002ULL,
-    0x1c004001012080ULL,
-    0x8004200962a00220ULL,
-    0x8422100208500202ULL,
-    0x2000402200300c08ULL,
-    0x8646020080080080ULL,
-    0x80020a0200100808ULL,
-    0x2010004880111000ULL,
-    0x623000a080011400ULL,
-    0x42008c0340209202ULL,
-    0x209188240001000ULL,
-    0x400408a884001800ULL,
-    0x110400a6080400ULL,
-    0x1840060a44020800ULL,
-    0x90080104000041ULL,
-    0x201011000808101ULL,
-    0x1a2208080504f080ULL,
-    0x8012020600211212ULL,
-    0x500861011240000ULL,
-    0x180806108200800ULL,
-    0x4000020e01040044ULL,
-    0x300000261044000aULL,
-    0x802241102020002ULL,
-    0x20906061210001ULL,
-    0x5a84841004010310ULL,
-    0x4010801011c04ULL,
-    0xa010109502200ULL,
-    0x4a02012000ULL,
-    0x500201010098b028ULL,
-    0x8040002811040900ULL,
-    0x28000010020204ULL,
-    0x6000020202d0240ULL,
-    0x8918844842082200ULL,
-    0x4010011029020020ULL};
-
-u64 pawn_attacks[2][64];
-u64 knight_attacks[64];
-u64 king_attacks[64];
-u64 bishop_masks[64];
-u64 rook_masks[64];
-// bishop attack tables [square][occupancies]
-u64 bishop_attacks[64][512];
-// rook attack tables [square][occupancies]
-u64 rook_attacks[64][4096];
-
-// generate pawn attacks
-u64 mask_pawn_attacks(int side, int square)
-{
-  u64 attacks = 0ULL;
-  u64 bitboard = 0ULL;
-  set_bit(bitboard, square);
-
-  if (side == 0) // white
-  {
-    if ((bitboard >> 7) & not_a_file)
-      attacks |= (bitboard >> 7);
-    if ((bitboard >> 9) & not_h_file)
-      attacks |= (bitboard >> 9);
-  }
-  else // black
-  {
-    if ((bitboard << 7) & not_h_file)
-      attacks |= (bitboard << 7);
-    if ((bitboard << 9) & not_a_file)
-      attacks |= (bitboard << 9);
-  }
-
-  return attacks;
-}
-
-// generate knight attacks
-u64 mask_knight_attacks(int square)
-{
-  u64 attacks = 0ULL;
-  u64 bitboard = 0ULL;
-  set_bit(bitboard, square);
-  // print_bitboard(bitboard);
-
-  if ((bitboard >> 17) & not_h_file)
-    attacks |= (bitboard >> 17);
-  if ((bitboard) >> 15 & not_a_file)
-    attacks |= (bitboard >> 15);
-  if ((bitboard >> 10) & not_hg_file)
-    attacks |= (bitboard >> 10);
-  if ((bitboard >> 6) & not_ab_file)
-    attacks |= (bitboard >> 6);
-
-  if ((bitboard << 17 & not_a_file))
-    attacks |= (bitboard << 17);
-  if ((bitboard) << 15 & not_h_file)
-    attacks |= (bitboard << 15);
-  if ((bitboard << 10) & not_ab_file)
-    attacks |= (bitboard << 10);
-  if ((bitboard << 6) & not_hg_file)
-    attacks |= (bitboard << 6);
-
-  return attacks;
-}
-
-// generate king attacks
-u64 mask_king_attacks(int square)
-{
-  u64 attacks = 0ULL;
-  u64 bitboard = 0ULL;
-  set_bit(bitboard, square);
-  // print_bitboard(bitboard);
-  if (bitboard >> 8)
-    attacks |= (bitboard >> 8);
-  if (bitboard << 8)
-    attacks |= (bitboard << 8);
-  if ((bitboard >> 9) & not_h_file)
-    attacks |= (bitboard >> 9);
-  if ((bitboard >> 7) & not_a_file)
-    attacks |= (bitboard >> 7);
-  if ((bitboard << 9) & not_a_file)
-    attacks |= (bitboard << 9);
-  if ((bitboard << 7) & not_h_file)
-    attacks |= (bitboard << 7);
-  if ((bitboard << 1) & not_a_file)
-    attacks |= (bitboard << 1);
-  if ((bitboard >> 1) & not_h_file)
-    attacks |= (bitboard >> 1);
-
-  return attacks;
-}
-
-// mask bishop attacks
-u64 mask_bishop_attacks(int square)
-{
-  u64 attacks = 0ULL;
-  int r, f;
-  int tr = square / 8;
-  int tf = square % 8;
-
-  for (r = tr + 1, f = tf + 1; r <= 6 && f <= 6; r++, f++)
-    attacks |= (1ULL << (r * 8 + f));
-
-  for (r = tr - 1, f = tf - 1; r >= 1 && f >= 1; r--, f--)
-    attacks |= (1ULL << (r * 8 + f));
-
-  for (r = tr + 1, f = tf - 1; r <= 6 && f >= 1; r++, f--)
-    attacks |= (1ULL << (r * 8 + f));
-
-  for (r = tr - 1, f = tf + 1; r >= 1 && f <= 6; r--, f++)
-    attacks |= (1ULL << (r * 8 + f));
-
-  return attacks;
-}
-
-// mask rook attacks
-u64 mask_rook_attacks(int square)
-{
-  u64 attacks = 0ULL;
-  int r, f;
-  int tr = square / 8;
-  int tf = square % 8;
-
-  for (int r = tr + 1; r <= 6; r++)
-    attacks |= (1ULL << (r * 8 + tf));
-  for (int r = tr - 1; r >= 1; r--)
-    attacks |= (1ULL << (r * 8 + tf));
-  for (int f = tf + 1; f <= 6; f++)
-    attacks |= (1ULL << (tr * 8 + f));
-  for (int f = tf - 1; f >= 1; f--)
-    attacks |= (1ULL << (tr * 8 + f));
-
-  return attacks;
-}
-
-// generate bishop attacks on fly
-u64 bishop_attacks_on_the_fly(int square, u64 block)
-{
-  u64 attacks = 0ULL;
-  int r, f;
-  int tr = square / 8;
-  int tf = square % 8;
-
-  for (r = tr + 1, f = tf + 1; r <= 7 && f <= 7; r++, f++)
-  {
-    attacks |= (1ULL << (r * 8 + f));
-    if ((1ULL << (r * 8 + f)) & block)
-      break;
-  }
-
-  for (r = tr - 1, f = tf - 1; r >= 0 && f >= 0; r--, f--)
-  {
-    attacks |= (1ULL << (r * 8 + f));
-    if ((1ULL << (r * 8 + f)) & block)
-      break;
-  }
-
-  for (r = tr + 1, f = tf - 1; r <= 7 && f >= 0; r++, f--)
-  {
-    attacks |= (1ULL << (r * 8 + f));
-    if ((1ULL << (r * 8 + f)) & block)
-      break;
-  }
-
-  for (r = tr - 1, f = tf + 1; r >= 0 && f <= 7; r--, f++)
-  {
-    attacks |= (1ULL << (r * 8 + f));
-    if ((1ULL << (r * 8 + f)) & block)
-      break;
-  }
-
-  return attacks;
-}
-
-// generate rook attacks on fly
-u64 rook_attacks_on_the_fly(int square, u64 block)
-{
-  u64 attacks = 0ULL;
-  int r, f;
-  int tr = square / 8;
-  int tf = square % 8;
-
-  for (int r = tr + 1; r <= 7; r++)
-  {
-    attacks |= (1ULL << (r * 8 + tf));
-    if ((1ULL << (r * 8 + tf)) & block)
-      break;
-  }
-  for (int r = tr - 1; r >= 0; r--)
-  {
-    attacks |= (1ULL << (r * 8 + tf));
-    if ((1ULL << (r * 8 + tf)) & block)
-      break;
-  }
-  for (int f = tf + 1; f <= 7; f++)
-  {
-    attacks |= (1ULL << (tr * 8 + f));
-    if ((1ULL << (tr * 8 + f)) & block)
-      break;
-  }
-  for (int f = tf - 1; f >= 0; f--)
-  {
-    attacks |= (1ULL << (tr * 8 + f));
-    if ((1ULL << (tr * 8 + f)) & block)
-      break;
-  }
-
-  return attacks;
-}
-
-// set occupancies
-u64 set_occupancy(int index, int bits_in_mask, u64 attack_mask)
-{
-  u64 occupancy = 0ULL;
-
-  for (int count = 0; count < bits_in_mask; count++)
-  {
-    int square = get_lsb1st_index(attack_mask);
-    pop_bit(attack_mask, square);
-
-    if (index & (1ULL << count))
-    {
-      occupancy |= (1ULL << square);
-    }
-  }
-
-  return occupancy;
-}
-
-// init leaper pieces attacks
-void init_leapers_attacks()
-{
-  for (int sq = 0; sq < 64; sq++)
-  {
-    pawn_attacks[white][sq] = mask_pawn_attacks(white, sq);
-    pawn_attacks[black][sq] = mask_pawn_attacks(black, sq);
-
-    knight_attacks[sq] = mask_knight_attacks(sq);
-
-    king_attacks[sq] = mask_king_attacks(sq);
-  }
-}
-
-// finding magic numbers
-u64 find_magic_number(int square, int relevant_bits, int bishop)
-{
-  u64 occupancies[4096];
-
-  u64 attacks[4096];
-
-  u64 used_attacks[4096];
-
-  u64 attack_mask = bishop ? mask_bishop_attacks(square) : mask_rook_attacks(square);
-
-  int occupancy_indices = 1 << relevant_bits;
-
-  for (int index = 0; index < occupancy_indices; index++)
-  {
-    occupancies[index] = set_occupancy(index, relevant_bits, attack_mask);
-    attacks[index] = bishop ? bishop_attacks_on_the_fly(square, occupancies[index]) : rook_attacks_on_the_fly(square, occupancies[index]);
-  }
-
-  // test magic loop
-  for (int random_count = 0; random_count < 100000000; random_count++)
-  {
-    // generate magic number candidate
-    u64 magic_number = generate_magic_number();
-
-    // skip inappropiate magic numbers
-    if (count_bits((attack_mask * magic_number) & 0xFF00000000000000) < 6)
-    {
-      continue;
-    }
-
-    // init used_attacks
-    memset(used_attacks, 0ULL, sizeof(used_attacks));
-
-    // init index & fail flag
-    int index, fail;
-
-    // test magic index loop
-    for (index = 0, fail = 0; !fail && index < occupancy_indices; index++)
-    {
-      int magic_index = (int)((occupancies[index] * magic_number) >> (64 - relevant_bits));
-
-      // if magic index works
-      if (used_attacks[magic_index] == 0ULL)
-      {
-        used_attacks[magic_index] = attacks[index];
-      }
-      else if (used_attacks[magic_index] != attacks[index])
-      {
-        fail = 1;
-      }
-    }
-
-    if (!fail)
-    {
-      return magic_number;
-    }
-  }
-  printf("    Magic number fails");
-  return 0ULL;
-}
-
-// init magic numbers
-void init_magic_numbers()
-{
-  for (int square = 0; square < 64; square++)
-  {
-    // init rook magic number
-    rook_magic_numbers[square] = find_magic_number(square, rook_relevant_bits[square], rook);
-  }
-
-  printf("\n\n");
-
-  for (int square = 0; square < 64; square++)
-  {
-    // init bishop magic number
-    bishop_magic_numbers[square] = find_magic_number(square, bishop_relevant_bits[square], bishop);
-  }
-}
-
-// init slider peices attack tables
-void init_sliders_attacks(int bishop)
-{
-  for (int square = 0; square < 64; square++)
-  {
-    bishop_masks[square] = mask_bishop_attacks(square);
-    rook_masks[square] = mask_rook_attacks(square);
-
-    // init current mask
-    u64 attack_mask = bishop ? bishop_masks[square] : rook_masks[square];
-
-    // init relevant occupancy bit count
-    int relevant_bits_count = count_bits(attack_mask);
-
-    // init occupancies
-    int occupancy_indices = (1 << relevant_bits_count);
-
-    for (int index = 0; index < occupancy_indices; index++)
-    {
-      if (bishop)
-      {
-        // init current occupancy variation
-        u64 occupancy = set_occupancy(index, relevant_bits_count, attack_mask);
-
-        // init magic index
-        int magic_index = (occupancy * bishop_magic_numbers[square]) >> (64 - bishop_relevant_bits[square]);
-
-        // init bishop attacks
-        bishop_attacks[square][magic_index] = bishop_attacks_on_the_fly(square, occupancy);
-      }
-      else
-      {
-        // init current occupancy variation
-        u64 occupancy = set_occupancy(index, relevant_bits_count, attack_mask);
-
-        // init magic index
-        int magic_index = (occupancy * rook_magic_numbers[square]) >> (64 - rook_relevant_bits[square]);
-
-        // init bishop attacks
-        rook_attacks[square][magic_index] = rook_attacks_on_the_fly(square, occupancy);
-      }
-    }
-  }
-}
-
-static inline u64 get_bishop_attacks(int square, u64 occupancy)
-{
-  // get bishop attacks assuming current board occupancy
-  occupancy &= bishop_masks[square];
-  occupancy *= bishop_magic_numbers[square];
-  occupancy >>= (64 - bishop_relevant_bits[square]);
-
-  return bishop_attacks[square][occupancy];
-}
-
-static inline u64 get_queen_attacks(int square, u64 occupancy)
-{
-  // init result attack bitboard
-  u64 queen_attacks = 0ULL;
-  // intit bishop occupancies
-  u64 bishop_occupancy = occupancy;
-  // intit rook occupancies
-  u64 rook_occupancy = occupancy;
-
-  // get bishop attacks assuming current board occupancy
-  bishop_occupancy &= bishop_masks[square];
-  bishop_occupancy *= bishop_magic_numbers[square];
-  bishop_occupancy >>= (64 - bishop_relevant_bits[square]);
-
-  queen_attacks = bishop_attacks[square][bishop_occupancy];
-
-  // get rook attacks assuming current board occupancy
-  rook_occupancy &= rook_masks[square];
-  rook_occupancy *= rook_magic_numbers[square];
-  rook_occupancy >>= (64 - rook_relevant_bits[square]);
-
-  queen_attacks |= rook_attacks[square][rook_occupancy];
-
-  return queen_attacks;
-}
-
-static inline u64 get_rook_attacks(int square, u64 occupancy)
-{
-  // get rook attacks assuming current board occupancy
-  occupancy &= rook_masks[square];
-  occupancy *= rook_magic_numbers[square];
-  occupancy >>= (64 - rook_relevant_bits[square]);
-
-  return rook_attacks[square][occupancy];
-}
-
-/*
- *
- *                Move Generation
- *
- */
-
-//  is current given square attacked by the current givrn side
-static inline int is_square_attacked(int square, int side)
-{
-  // attacked by white pawns
-  if ((side == white) && (pawn_attacks[black][square] & bitboards[P]))
-    return 1;
-
-  // attacked by black pawns
-  if ((side == black) && (pawn_attacks[white][square] & bitboards[p]))
-    return 1;
-
-  // attacked by knights
-  if (knight_attacks[square] & ((side == white) ? bitboards[N] : bitboards[n]))
-    return 1;
-
-  // attacked by bishops
-  if (get_bishop_attacks(square, occupancies[both]) & ((side == white) ? bitboards[B] : bitboards[b]))
-    return 1;
-
-  // attacked by rooks
-  if (get_rook_attacks(square, occupancies[both]) & ((side == white) ? bitboards[R] : bitboards[r]))
-    return 1;
-
-  // attacked by queens
-  if (get_queen_attacks(square, occupancies[both]) & ((side == white) ? bitboards[Q] : bitboards[q]))
-    return 1;
-
-  // attacked by kings
-  if (king_attacks[square] & ((side == white) ? bitboards[K] : bitboards[k]))
-    return 1;
-
-  return 0;
-}
-
-void print_attacked_squares(int side)
-{
-  printf("\n");
-  for (int rank = 0; rank < 8; rank++)
-  {
-    for (int file = 0; file < 8; file++)
-    {
-      int square = rank * 8 + file;
-      if (!file)
-        printf("  %d  ", 8 - rank);
-
-      printf("%d ", is_square_attacked(square, side) ? 1 : 0);
-    }
-    printf("\n");
-  }
-
-  printf("\n     A B C D E F G H \n\n");
-}
-
-/*
- *    Binary Move Bits                                            hexadecimal constants
- *
- *    0000 0000 0000 0000 0011 1111    source square              0x3f
- *    0000 0000 0000 1111 1100 0000    target square              0xfc0
- *    0000 0000 1111 0000 0000 0000    piece                      0xf000
- *    0000 1111 0000 0000 0000 0000    promoted piece             0xf0000
- *    0001 0000 0000 0000 0000 0000    capture flag               0x100000
- *    0010 0000 0000 0000 0000 0000    double push flag           0x200000
- *    0100 0000 0000 0000 0000 0000    enpassant flag             0x400000
- *    1000 0000 0000 0000 0000 0000    castling flag              0x800000
- */
-
-// encode move
-#define encode_move(source, target, piece, promoted, capture, double, enpassant, castling) \
-  (source) | (target << 6) | (piece << 12) | (promoted << 16) | (capture << 20) | (double << 21) | (enpassant << 22) | (castling << 23)
-
-// extract source square
-#define get_move_source(move) (move & 0x3f)
-
-// extract target square
-#define get_move_target(move) ((move & 0xfc0) >> 6)
-
-// extract piece
-#define get_move_piece(move) ((move & 0xf000) >> 12)
-
-// extract promoted piece
-#define get_move_promoted(move) ((move & 0xf0000) >> 16)
-
-// extract capture flag
-#define get_move_capture(move) ((move & 0x100000))
-
-// extract double push flag
-#define get_move_double(move) ((move & 0x200000))
-
-// extract enpassant flag
-#define get_move_enpassant(move) ((move & 0x400000))
-
-// extract castling flag
-#define get_move_castle(move) ((move & 0x800000))
-
-// move list structutre
-typedef struct
-{
-  // moves
-  int moves[256];
-
-  // move count
-  int count;
-
-} moves;
-
-static inline void add_move(moves *move_list, int move)
-{
-  // store move
-  move_list->moves[move_list->count] = move;
-
-  // increment move count
-  move_list->count++;
-}
-
-// print move (for UCI purpose)
-void print_move(int move)
-{
-  printf("%s %s %c\n", square_to_coordinates[get_move_source(move)], square_to_coordinates[get_move_target(move)], promoted_pieces[get_move_promoted(move)]);
-}
-
-// print move (for debuging functions)
-void print_move_list(moves *move_list)
-
-{
-  if (!move_list->count)
-  {
-    printf("\n       No Moves in the move list\n\n");
-    return;
-  }
-  printf("\n       move   piece   capture   double   enpassant   castling\n\n");
-  for (int move_count = 0; move_count < move_list->count; move_count++)
-  {
-    // init move
-    int move = move_list->moves[move_count];
-#ifdef WIN64
-    printf("     %s%s%c   %c         %d        %d          %d          %d\n", square_to_coordinates[get_move_source(move)], square_to_coordinates[get_move_target(move)], promoted_pieces[get_move_promoted(move)] ? promoted_pieces[get_move_promoted(move)] : ' ', ascii_pieces[get_move_piece(move)], get_move_capture(move) ? 1 : 0, get_move_double(move) ? 1 : 0, get_move_enpassant(move) ? 1 : 0, get_move_castle(move) ? 1 : 0);
-#else
-    printf("     %s%s%c   %s         %d        %d          %d          %d\n", square_to_coordinates[get_move_source(move)], square_to_coordinates[get_move_target(move)], (promoted_pieces[get_move_promoted(move)] ? promoted_pieces[get_move_promoted(move)] : ' '), unicode_pieces[get_move_piece(move)], get_move_capture(move) ? 1 : 0, get_move_double(move) ? 1 : 0, get_move_enpassant(move) ? 1 : 0, get_move_castle(move) ? 1 : 0);
-#endif
-
-    // total number of moves
-  }
-  printf("\n\n     Total number of moves: %d\n", move_list->count);
-}
-
-#define copy_board()                           \
-  u64 bitboards_copy[12], occupancies_copy[3]; \
-  int side_copy, enpassant_copy, castle_copy;  \
-  memcpy(bitboards_copy, bitboards, 96);       \
-  memcpy(occupancies_copy, occupancies, 24);   \
-  side_copy = side, enpassant_copy = enpassant, castle_copy = castle;
-
-#define take_back()                          \
-  memcpy(bitboards, bitboards_copy, 96);     \
-  memcpy(occupancies, occupancies_copy, 24); \
-  side = side_copy, enpassant = enpassant_copy, castle = castle_copy;
-
-enum
-{
-  all_moves,
-  only_captures
-};
-
-/*
- * king & rooks didnt move :   1111 & 1111 = 1111  15
- *
- * white king moved        :   1111 & 1100 = 1100  12
- * white kings rook moved  :   1111 & 1110 = 1110  14
- * white queen rook moved  :   1111 & 1101 = 1101  13
- *
- * black king moved        :   1111 & 0011 = 1100  03
- * black kings rook moved  :   1111 & 1011 = 1011  11
- * black queen rook moved  :   1111 & 0111 = 0111  07
- */
-
-// castling rights upadte constants
-const int castling_rights[64] = {
-    07, 15, 15, 15, 03, 15, 15, 11,
-    15, 15, 15, 15, 15, 15, 15, 15,
-    15, 15, 15, 15, 15, 15, 15, 15,
-    15, 15, 15, 15, 15, 15, 15, 15,
-    15, 15, 15, 15, 15, 15, 15, 15,
-    15, 15, 15, 15, 15, 15, 15, 15,
-    15, 15, 15, 15, 15, 15, 15, 15,
-    13, 15, 15, 15, 12, 15, 15, 14};
-
-static inline int make_move(int move, int move_flag)
-{
-  // quite moves
-  if (move_flag == all_moves)
-  {
-    copy_board();
-
-    // parse move
-    int source_square = get_move_source(move);
-    int target_square = get_move_target(move);
-    int piece = get_move_piece(move);
-    int promoted_piece = get_move_promoted(move);
-    int capture = get_move_capture(move);
-    int double_push = get_move_double(move);
-    int enpass = get_move_enpassant(move);
-    int castling = get_move_castle(move);
-
-    // move piece
-    pop_bit(bitboards[piece], source_square);
-    set_bit(bitboards[piece], target_square);
-
-    // handling capture moves
-    if (capture)
-    {
-      // pick up bitboard piece index ranges depending on sign
-      int start_piece, end_piece;
-
-      // white to move
-      if (side == white)
-      {
-        start_piece = p;
-        end_piece = k;
-      }
-      // black to move
-      else
-      {
-        start_piece = P;
-        end_piece = K;
-      }
-
-      for (int bb_piece = start_piece; bb_piece <= end_piece; bb_piece++)
-      {
-
-        if (get_bit(bitboards[bb_piece], target_square))
-        {
-          pop_bit(bitboards[bb_piece], target_square);
-          break;
-        }
-      }
-    }
-
-    // handle pawn promotions
-    if (promoted_piece)
-    {
-      // erase the pawn from target square
-      pop_bit(bitboards[(side == white) ? P : p], target_square);
-
-      // set up promoted piece on chess board
-      set_bit(bitboards[promoted_piece], target_square);
-    }
-
-    // handle enpassant capture
-    if (enpass)
-    {
-      // erase the pawn depending on side to move
-      (side == white) ? pop_bit(bitboards[p], target_square + 8) : pop_bit(bitboards[P], target_square - 8);
-    }
-
-    // reset enpassant square
-    enpassant = no_sq;
-
-    if (double_push)
-    {
-      (side == white) ? (enpassant = target_square + 8) : (enpassant = target_square - 8);
-    }
-
-    if (castling)
-    {
-      switch (target_square)
-      {
-      // white castles king side
-      case (g1):
-        // move H rook
-        pop_bit(bitboards[R], h1);
-        set_bit(bitboards[R], f1);
-        break;
-        // white castles queen side
-      case (c1):
-        pop_bit(bitboards[R], a1);
-        set_bit(bitboards[R], d1);
-        break;
-        // black castles king side
-      case (g8):
-        pop_bit(bitboards[r], h8);
-        set_bit(bitboards[r], f8);
-        break;
-        // black castles queen side
-      case (c8):
-        pop_bit(bitboards[r], a8);
-        set_bit(bitboards[r], d8);
-        break;
-
-      default:
-        break;
-      }
-    }
-
-    castle &= castling_rights[source_square];
-    castle &= castling_rights[target_square];
-
-    // reset occupancies
-    memset(occupancies, 0ULL, 24);
-
-    // loop over white pieces
-    for (int bb_piece = P; bb_piece <= K; bb_piece++)
-    {
-      // update white occupancies
-      occupancies[white] |= bitboards[bb_piece];
-    }
-
-    // loop over bloack pieces
-    for (int bb_piece = p; bb_piece <= k; bb_piece++)
-    {
-      // update black occupancies
-      occupancies[black] |= bitboards[bb_piece];
-    }
-
-    // update both side occupancies
-    occupancies[both] |= occupancies[white];
-    occupancies[both] |= occupancies[black];
-
-    // change side
-    side ^= 1;
-
-    // make sure that the king is not exposed
-    if (is_square_attacked((side == white) ? get_lsb1st_index(bitboards[k]) : get_lsb1st_index(bitboards[K]), side))
-    {
-      // take move back
-      take_back();
-
-      return 0;
-    }
-    else
-    {
-      return 1;
-    }
-  }
-  // capture moves
-  else
-  {
-    if (get_move_capture(move))
-    {
-      make_move(move, all_moves);
-    }
-    else
-    {
-      return 0;
-    }
-  }
-}
-
-static inline void generate_moves(moves *move_list)
-{
-  // init move count
-  move_list->count = 0;
-
-  int source_square, target_square;
-
-  // bitboards copy and attack
-  u64 bitboard, attacks;
-
-  for (int piece = P; piece <= k; piece++)
-  {
-    bitboard = bitboards[piece];
-
-    // generate white pawns and white king castling moves
-    if (side == white)
-    {
-      if (piece == P)
-      {
-        // loop over white pawns within white pawn bitboard
-        while (bitboard)
-        {
-          // init source square
-          source_square = get_lsb1st_index(bitboard);
-          // init target square
-          target_square = source_square - 8;
-
-          // generate quite pawn moves
-          if (!(target_square < a8) && !get_bit(occupancies[both], target_square))
-          {
-            // pawn promotion
-            if (source_square >= a7 && source_square <= h7)
-            {
-              // add move into a move list
-              add_move(move_list, encode_move(source_square, target_square, piece, Q, 0, 0, 0, 0));
-              add_move(move_list, encode_move(source_square, target_square, piece, R, 0, 0, 0, 0));
-              add_move(move_list, encode_move(source_square, target_square, piece, B, 0, 0, 0, 0));
-              add_move(move_list, encode_move(source_square, target_square, piece, N, 0, 0, 0, 0));
-            }
-            else
-            {
-              // one square ahead move
-              add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
-
-              // two square ahead move
-              if ((source_square >= a2 && source_square <= h2) && !get_bit(occupancies[both], target_square - 8))
-              {
-                add_move(move_list, encode_move(source_square, target_square - 8, piece, 0, 0, 1, 0, 0));
-              }
-            }
-          }
-
-          // init pawn attacks bitboard
-          attacks = pawn_attacks[side][source_square] & occupancies[black];
-
-          // generate pawn captures
-          while (attacks)
-          {
-            // init target square
-            target_square = get_lsb1st_index(attacks);
-            if (source_square >= a7 && source_square <= h7)
-            {
-              // add move into a move list
-              add_move(move_list, encode_move(source_square, target_square, piece, Q, 1, 0, 0, 0));
-              add_move(move_list, encode_move(source_square, target_square, piece, R, 1, 0, 0, 0));
-              add_move(move_list, encode_move(source_square, target_square, piece, B, 1, 0, 0, 0));
-              add_move(move_list, encode_move(source_square, target_square, piece, N, 1, 0, 0, 0));
-            }
-            else
-              // one square ahead move
-              add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
-
-            pop_bit(attacks, target_square);
-          }
-
-          //  generate enpassant captures
-          if (enpassant != no_sq)
-          {
-            // gives us the square where enpassant can be done
-            u64 enpassant_attacks = pawn_attacks[side][source_square] & (1ULL << enpassant);
-
-            if (enpassant_attacks)
-            {
-              // init enpassant target square
-              int target_enpassant = get_lsb1st_index(enpassant_attacks);
-              add_move(move_list, encode_move(source_square, target_enpassant, piece, 0, 1, 0, 1, 0));
-            }
-          }
-
-          // pop lsb1 bit from piece bitboard_copy
-          pop_bit(bitboard, source_square);
-        }
-      }
-
-      // white castling moves
-      if (piece == K)
-      {
-        // king side catling is availiable
-        if (castle & wk)
-        {
-          // make sure square between king and the king side rook are empty
-          if (!get_bit(occupancies[both], f1) && !get_bit(occupancies[both], g1))
-          {
-            // make sure king and f1 square are not attacked by enemy pieces
-            if (!is_square_attacked(e1, black) && !is_square_attacked(f1, black))
-            {
-              add_move(move_list, encode_move(e1, g1, piece, 0, 0, 0, 0, 1));
-            }
-          }
-        }
-        // queen side catling is availiable
-        if (castle & wq)
-        {
-          // make sure square between king and the queen side rook are empty
-          if (!get_bit(occupancies[both], d1) && !get_bit(occupancies[both], c1) && !get_bit(occupancies[both], b1))
-          {
-            // make sure king and d1 square are not attacked by enemy pieces
-            if (!is_square_attacked(e1, black) && !is_square_attacked(d1, black))
-            {
-              add_move(move_list, encode_move(e1, c1, piece, 0, 0, 0, 0, 1));
-            }
-          }
-        }
-      }
-    }
-
-    // generate black pawns and white king castling moves
-    else
-    {
-      if (piece == p)
-      {
-        // loop over black pawns within black pawn bitboard
-        while (bitboard)
-        {
-          // init source square
-          source_square = get_lsb1st_index(bitboard);
-          // init target square
-          target_square = source_square + 8;
-
-          // generate quite pawn moves
-          if (!(target_square > h1) && !get_bit(occupancies[both], target_square))
-          {
-            // pawn promotion
-            if (source_square >= a2 && source_square <= h2)
-            {
-              // add move into a move list
-              add_move(move_list, encode_move(source_square, target_square, piece, q, 0, 0, 0, 0));
-              add_move(move_list, encode_move(source_square, target_square, piece, r, 0, 0, 0, 0));
-              add_move(move_list, encode_move(source_square, target_square, piece, b, 0, 0, 0, 0));
-              add_move(move_list, encode_move(source_square, target_square, piece, n, 0, 0, 0, 0));
-            }
-            else
-            {
-              // one square ahead move
-              add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
-
-              // two square ahead move
-              if ((source_square >= a7 && source_square <= h7) && !get_bit(occupancies[both], target_square + 8))
-              {
-                add_move(move_list, encode_move(source_square, target_square + 8, piece, 0, 0, 1, 0, 0));
-              }
-            }
-          }
-
-          // init pawn attacks bitboard
-          attacks = pawn_attacks[side][source_square] & occupancies[white];
-
-          // generate pawn captures
-          while (attacks)
-          {
-            // init target square
-            target_square = get_lsb1st_index(attacks);
-            if (source_square >= a2 && source_square <= h2)
-            {
-              // add move into a move list
-              add_move(move_list, encode_move(source_square, target_square, piece, q, 1, 0, 0, 0));
-              add_move(move_list, encode_move(source_square, target_square, piece, r, 1, 0, 0, 0));
-              add_move(move_list, encode_move(source_square, target_square, piece, b, 1, 0, 0, 0));
-              add_move(move_list, encode_move(source_square, target_square, piece, n, 1, 0, 0, 0));
-            }
-            else
-              // one square ahead move
-              add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
-
-            pop_bit(attacks, target_square);
-          }
-
-          //  generate enpassant captures
-          if (enpassant != no_sq)
-          {
-            // gives us the square where enpassant can be done
-            u64 enpassant_attacks = pawn_attacks[side][source_square] & (1ULL << enpassant);
-
-            if (enpassant_attacks)
-            {
-              // init enpassant target square
-              int target_enpassant = get_lsb1st_index(enpassant_attacks);
-              add_move(move_list, encode_move(source_square, target_enpassant, piece, 0, 1, 0, 1, 0));
-            }
-          }
-
-          // pop lsb1 bit from piece bitboard_copy
-          pop_bit(bitboard, source_square);
-        }
-      }
-
-      // black castling moves
-      if (piece == k)
-      {
-        // king side castling is availiable
-        if (castle & bk)
-        {
-          // make sure square between king and the king side rook are empty
-          if (!get_bit(occupancies[both], f8) && !get_bit(occupancies[both], g8))
-          {
-            // make sure king and f8 square are not attacked by enemy pieces
-            if (!is_square_attacked(e8, white) && !is_square_attacked(f8, white))
-            {
-              add_move(move_list, encode_move(e8, g8, piece, 0, 0, 0, 0, 1));
-            }
-          }
-        }
-
-        // queen side castling is availiable
-        if (castle & bq)
-        {
-          // make sure square between king and the queen side rook are empty
-          if (!get_bit(occupancies[both], d8) && !get_bit(occupancies[both], c8) && !get_bit(occupancies[both], b8))
-          {
-            // make sure king and d8 square are not attacked by enemy pieces
-            if (!is_square_attacked(e8, white) && !is_square_attacked(d8, white))
-            {
-              add_move(move_list, encode_move(e8, c8, piece, 0, 0, 0, 0, 1));
-            }
-          }
-        }
-      }
-    }
-
-    // generate knight moves
-    if ((side == white) ? piece == N : piece == n)
-    {
-      // loop over source squares of piece bitboard copy
-      while (bitboard)
-      {
-        // init source square
-        source_square = get_lsb1st_index(bitboard);
-        // init piece attacks in order to get set of target squares
-        attacks = knight_attacks[source_square] & ((side == white) ? ~occupancies[white] : ~occupancies[black]);
-
-        // loop over target squares available from generated attacks
-        while (attacks)
-        {
-          // init target square
-          target_square = get_lsb1st_index(attacks);
-
-          // quite moves
-          if (!get_bit((side == white) ? occupancies[black] : occupancies[white], target_square))
-          {
-            add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
-          }
-          // capture moves
-          else
-          {
-            add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
-          }
-
-          // pop ls1b in attacks
-          pop_bit(attacks, target_square);
-        }
-
-        // pop the bit
-        pop_bit(bitboard, source_square);
-      }
-    }
-
-    // generate bishop moves
-    if ((side == white) ? piece == B : piece == b)
-    {
-      // loop over source squares of piece bitboard copy
-      while (bitboard)
-      {
-        // init source square
-        source_square = get_lsb1st_index(bitboard);
-        // init piece attacks in order to get set of target squares
-        attacks = get_bishop_attacks(source_square, occupancies[both]) & ((side == white) ? ~occupancies[white] : ~occupancies[black]);
-
-        // loop over target squares available from generated attacks
-        while (attacks)
-        {
-          // init target square
-          target_square = get_lsb1st_index(attacks);
-
-          // quite moves
-          if (!get_bit((side == white) ? occupancies[black] : occupancies[white], target_square))
-          {
-            add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
-          }
-          // capture moves
-          else
-          {
-            add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
-          }
-
-          // pop ls1b in attacks
-          pop_bit(attacks, target_square);
-        }
-
-        // pop the bit
-        pop_bit(bitboard, source_square);
-      }
-    }
-
-    // generate rook moves
-    if ((side == white) ? piece == R : piece == r)
-    {
-      // loop over source squares of piece bitboard copy
-      while (bitboard)
-      {
-        // init source square
-        source_square = get_lsb1st_index(bitboard);
-        // init piece attacks in order to get set of target squares
-        attacks = get_rook_attacks(source_square, occupancies[both]) & ((side == white) ? ~occupancies[white] : ~occupancies[black]);
-
-        // loop over target squares available from generated attacks
-        while (attacks)
-        {
-          // init target square
-          target_square = get_lsb1st_index(attacks);
-
-          // quite moves
-          if (!get_bit((side == white) ? occupancies[black] : occupancies[white], target_square))
-          {
-            add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
-          }
-          // capture moves
-          else
-          {
-            add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
-          }
-
-          // pop ls1b in attacks
-          pop_bit(attacks, target_square);
-        }
-
-        // pop the bit
-        pop_bit(bitboard, source_square);
-      }
-    }
-
-    // generate queen moves
-    if ((side == white) ? piece == Q : piece == q)
-    {
-      // loop over source squares of piece bitboard copy
-      while (bitboard)
-      {
-        // init source square
-        source_square = get_lsb1st_index(bitboard);
-        // init piece attacks in order to get set of target squares
-        attacks = get_queen_attacks(source_square, occupancies[both]) & ((side == white) ? ~occupancies[white] : ~occupancies[black]);
-
-        // loop over target squares available from generated attacks
-        while (attacks)
-        {
-          // init target square
-          target_square = get_lsb1st_index(attacks);
-
-          // quite moves
-          if (!get_bit((side == white) ? occupancies[black] : occupancies[white], target_square))
-          {
-            add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
-          }
-          // capture moves
-          else
-          {
-            add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
-          }
-
-          // pop ls1b in attacks
-          pop_bit(attacks, target_square);
-        }
-
-        // pop the bit
-        pop_bit(bitboard, source_square);
-      }
-    }
-
-    // generate king moves
-    if ((side == white) ? piece == K : piece == k)
-    {
-      // loop over source squares of piece bitboard copy
-      while (bitboard)
-      {
-        // init source square
-        source_square = get_lsb1st_index(bitboard);
-        // init piece attacks in order to get set of target squares
-        attacks = king_attacks[source_square] & ((side == white) ? ~occupancies[white] : ~occupancies[black]);
-
-        // loop over target squares available from generated attacks
-        while (attacks)
-        {
-          // init target square
-          target_square = get_lsb1st_index(attacks);
-
-          // quite moves
-          if (!get_bit((side == white) ? occupancies[black] : occupancies[white], target_square))
-          {
-            add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
-          }
-          // capture moves
-          else
-          {
-            add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
-          }
-
-          // pop ls1b in attacks
-          pop_bit(attacks, target_square);
-        }
-
-        // pop the bit
-        pop_bit(bitboard, source_square);
-      }
-    }
-  }
-}
-
-/*
- *
- *            Main Driver
- *
- */
-
-// get time in milliseconds
-int get_time_ms()
-{
-#ifdef WIN64
-  return GetTickCount();
-#else
-  struct timeval time_value;
-  gettimeofday(&time_value, NULL);
-  return time_value.tv_sec * 1000 + time_value.tv_usec / 1000;
-#endif
-}
-
-// init all
-void init_all()
-{
-  init_leapers_attacks();
-
-  init_sliders_attacks(bishop);
-  init_sliders_attacks(rook);
-}
-
-// leaf nodes (the number of position reached during the test of the move generator at a given depth)
-long nodes;
-
-// perft driver
-static inline void perft_driver(int depth)
-{
-  // recursion escape condition
-  if (depth == 0)
-  {
-    nodes++;
-    return;
-  }
-
-  moves move_list[1];
-  generate_moves(move_list);
-
-  for (int move_count = 0; move_count < move_list->count; move_count++)
-  {
-    // preserve board state
-    copy_board();
-
-    // make move
-    if (!make_move(move_list->moves[move_count], all_moves))
-    {
-      continue;
-    }
-
-    // call perft driver recursively
-    perft_driver(depth - 1);
-
-    take_back();
-  }
-}
-
-// perft test
-void perft_test(int depth)
-{
-  printf("\n     Performance Test: \n");
-
-  moves move_list[1];
-  generate_moves(move_list);
-  long start = get_time_ms();
-
-  for (int move_count = 0; move_count < move_list->count; move_count++)
-  {
-    // preserve board state
-    copy_board();
-
-    // make move
-    if (!make_move(move_list->moves[move_count], all_moves))
-    {
-      continue;
-    }
-
-    // cummulative nodes
-    long cummulative_nodes = nodes;
-    // call perft driver recursively
-    perft_driver(depth - 1);
-
-    long old_nodes = nodes - cummulative_nodes;
-
-    take_back();
-    printf("     %s %s %c   Nodes: %ld\n", square_to_coordinates[get_move_source(move_list->moves[move_count])], square_to_coordinates[get_move_target(move_list->moves[move_count])], promoted_pieces[get_move_promoted(move_list->moves[move_count])], old_nodes);
-  }
-
-  printf("\n     Depth: %d\n", depth);
-  printf("     Nodes: %ld\n", nodes);
-  printf("     Time: %ld\n\n", get_time_ms() - start);
-}
-
-int main()
-{
-  init_all();
-
-  parse_fen(start_position);
-  print_board();
-  // printf("%ld\n", sizeof(occupancies));
-
-  // start tracking time
-  // int start = get_time_ms();
-
-  perft_test(6);
-
-  return 0;
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#ifdef WIN64
+#include <windows.h>
+
+// lock a stream for a sequence of writes
+#define flockfile _lock_file
+#define funlockfile _unlock_file
+#else
+#include <sys/time.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+#define u64 unsigned long long
+
+// inline regardless of the compiler heuristics (one copy per constant argument, e.g. per side)
+#define force_inline static inline __attribute__((always_inline))
+
+// FEN debug positions
+#define empty_board "8/8/8/8/8/8/8/8 w - - "
+#define start_position "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 "
+#define tricky_position "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 "
+#define killer_position "rnbqkb1r/pp1p1pPp/8/2p1pP2/1P1P4/3P3P/P1P1P3/RNBQKBNR w KQkq e6 0 1"
+#define cmk_position "r2q1rk1/ppp2ppp/2n1bn2/2b1p3/3pP3/3P1NPP/PPP1NPB1/R1BQ1RK1 b - - 0 9 "
+
+#define get_bit(bitboard, square) ((bitboard) & (1ULL << (square)))
+#define set_bit(bitboard, square) ((bitboard) |= (1ULL << (square)))
+#define pop_bit(bitboard, square) ((bitboard) &= (~(1ULL << (square))))
+static inline int count_bits(u64 bitboard)
+{
+  // int count = 0;
+  // while (bitboard)
+  // {
+  //     bitboard &= bitboard - 1;
+  //     count++;
+  // }
+
+  // return count;
+
+  return __builtin_popcountll(bitboard);
+}
+static inline int get_lsb1st_index(u64 bitboard)
+{
+  // if (bitboard)
+  // {
+  //     return count_bits((bitboard & -bitboard) - 1);
+  // }
+  // else
+  // {
+  //     return -1;
+  // }
+
+  if (bitboard == 0)
+  {
+    return -1;
+  }
+
+  return __builtin_ctzll(bitboard);
+}
+
+// board squares
+enum
+{
+  a8,
+  b8,
+  c8,
+  d8,
+  e8,
+  f8,
+  g8,
+  h8,
+  a7,
+  b7,
+  c7,
+  d7,
+  e7,
+  f7,
+  g7,
+  h7,
+  a6,
+  b6,
+  c6,
+  d6,
+  e6,
+  f6,
+  g6,
+  h6,
+  a5,
+  b5,
+  c5,
+  d5,
+  e5,
+  f5,
+  g5,
+  h5,
+  a4,
+  b4,
+  c4,
+  d4,
+  e4,
+  f4,
+  g4,
+  h4,
+  a3,
+  b3,
+  c3,
+  d3,
+  e3,
+  f3,
+  g3,
+  h3,
+  a2,
+  b2,
+  c2,
+  d2,
+  e2,
+  f2,
+  g2,
+  h2,
+  a1,
+  b1,
+  c1,
+  d1,
+  e1,
+  f1,
+  g1,
+  h1,
+  no_sq
+};
+
+// sides to move
+enum
+{
+  white,
+  black,
+  both
+};
+
+// encode pieces
+enum
+{
+  P,
+  N,
+  B,
+  R,
+  Q,
+  K,
+  p,
+  n,
+  b,
+  r,
+  q,
+  k
+};
+
+// bishop and rook
+enum
+{
+  rook,
+  bishop
+};
+
+// castling bits binary representation
+/*
+ *    bin     dec
+ *    0001    1       white king castle to the king side
+ *    0010    2       white king castle to the queen side
+ *    0100    4       black king castle to the king side
+ *    1000    8       black king castle to the queen side
+ */
+
+enum
+{
+  wk = 1,
+  wq = 2,
+  bk = 4,
+  bq = 8
+};
+
+const char *square_to_coordinates[] = {
+    "A8", "B8", "C8", "D8", "E8", "F8", "G8", "H8",
+    "A7", "B7", "C7", "D7", "E7", "F7", "G7", "H7",
+    "A6", "B6", "C6", "D6", "E6", "F6", "G6", "H6",
+    "A5", "B5", "C5", "D5", "E5", "F5", "G5", "H5",
+    "A4", "B4", "C4", "D4", "E4", "F4", "G4", "H4",
+    "A3", "B3", "C3", "D3", "E3", "F3", "G3", "H3",
+    "A2", "B2", "C2", "D2", "E2", "F2", "G2", "H2",
+    "A1", "B1", "C1", "D1", "E1", "F1", "G1", "H1"};
+
+// ascii pieces
+char ascii_pieces[12] = "PNBRQKpnbrqk";
+
+// unicode pieces
+char *unicode_pieces[12] = {"♙", "♘", "♗", "♖", "♕", "♔", "♟", "♞", "♝", "♜", "♛", "♚"};
+
+// convert ascii character peices to encoded constants
+int char_pieces[] = {
+    ['P'] = P,
+    ['N'] = N,
+    ['B'] = B,
+    ['R'] = R,
+    ['Q'] = Q,
+    ['K'] = K,
+    ['p'] = p,
+    ['n'] = n,
+    ['b'] = b,
+    ['r'] = r,
+    ['q'] = q,
+    ['k'] = k};
+
+// promoted pieces
+char promoted_pieces[] = {
+    [Q] = 'q',
+    [R] = 'r',
+    [B] = 'b',
+    [N] = 'n',
+    [q] = 'q',
+    [r] = 'r',
+    [b] = 'b',
+    [n] = 'n'};
+
+void print_bitboard(u64 bitboard)
+{
+  printf("\n");
+  for (int rank = 0; rank < 8; rank++)
+  {
+    for (int file = 0; file < 8; file++)
+    {
+      if (file == 0)
+      {
+        printf("  %d  ", 8 - rank);
+      }
+      int square = rank * 8 + file;
+      printf("%d ", get_bit(bitboard, square) ? 1 : 0);
+    }
+    printf("\n");
+  }
+  printf("\n     A B C D E F G H \n");
+  printf("\n     Bitboard: %llud\n", bitboard);
+}
+
+/*
+ * Position state is thread local so that every search thread
+ * (batch workers, analysis sessions) owns an independent board
+ * while sharing the read-only attack and hash key tables
+ */
+
+// piece bitboards
+__thread u64 bitboards[12];
+
+// occupancy bitboards
+__thread u64 occupancies[3];
+
+// side to move
+__thread int side = 0;
+
+// enpassant square
+__thread int enpassant = no_sq;
+
+// castling rights
+__thread int castle;
+
+// "almost" unique position identifier aka hash key or position key
+__thread u64 hash_key;
+
+// pawn structure key (hash of the pawns only)
+__thread u64 pawn_key;
+
+// fifty move rule counter (half moves since last capture or pawn move)
+__thread int fifty;
+
+// repetition table size (game positions plus the search plies)
+#define max_repetitions 1000
+
+// positions repetition table (hash keys of the positions played so far)
+__thread u64 repetition_table[max_repetitions];
+
+// repetition index
+__thread int repetition_index;
+
+// pseudo random number state (per thread, self-play workers seed their own)
+__thread unsigned int random_state = 1804289383;
+
+// generate 32 bit pseudo legal numbers
+unsigned int get_random_u32_number()
+{
+  // get current random_state
+  unsigned int number = random_state;
+
+  // XOR shift algorithm
+  number ^= (number << 13);
+  number ^= (number >> 17);
+  number ^= (number << 5);
+
+  // update random number random_state
+  random_state = number;
+
+  return number;
+}
+
+// generate 64 bit pseudo legal numbers
+u64 get_random_u64_number()
+{
+  // define 4 random numbers
+  u64 n1, n2, n3, n4;
+
+  // init random numbers slicing 16 bits from MS1B side
+  n1 = (u64)(get_random_u32_number()) & 0xFFFF;
+  n2 = (u64)(get_random_u32_number()) & 0xFFFF;
+  n3 = (u64)(get_random_u32_number()) & 0xFFFF;
+  n4 = (u64)(get_random_u32_number()) & 0xFFFF;
+
+  return n1 | (n2 << 16) | (n3 << 32) | (n4 << 48);
+}
+
+// generate magic number candidate
+u64 generate_magic_number()
+{
+  return get_random_u64_number() & get_random_u64_number() & get_random_u64_number();
+}
+
+/*
+ *
+ *            Large Pages
+ *
+ *  The slider attack tables and the transposition table are probed at random
+ *  addresses, so with 4 KB pages nearly every probe is a TLB miss. They are
+ *  mapped on 2 MB pages when the system allows it:
+ *
+ *    explicit huge pages   MAP_HUGETLB, needs a reserved pool (sysctl vm.nr_hugepages)
+ *    transparent pages     madvise(MADV_HUGEPAGE) on a 2 MB aligned mapping
+ *    regular pages         plain anonymous mapping
+ *    malloc() block        if even the plain mapping fails
+ *
+ *  Where the table ended up is logged to stderr, away from the batch,
+ *  perft and UCI output on stdout.
+ *
+ */
+
+// huge page size
+#define huge_page_size (2 * 1024 * 1024)
+
+// round size up to whole huge pages
+#define huge_page_round(size) (((size) + huge_page_size - 1) & ~(size_t)(huge_page_size - 1))
+
+// allocate a large table on huge pages if possible (memory is not touched yet, NULL if out of memory)
+void *allocate_large(size_t size, char *name)
+{
+#ifndef WIN64
+  // tables smaller than a huge page would only waste most of it
+  if (size >= huge_page_size)
+  {
+    // init mapping size
+    size_t mapped = huge_page_round(size);
+
+    void *memory;
+
+#ifdef MAP_HUGETLB
+    // explicit huge pages
+    memory = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if (memory != MAP_FAILED)
+    {
+      fprintf(stderr, "info string %s: %zu KB on explicit huge pages\n", name, mapped / 1024);
+      return memory;
+    }
+#endif
+
+    // map one huge page more so that the table can start on a huge page boundary
+    char *raw = mmap(NULL, mapped + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (raw != MAP_FAILED)
+    {
+      // unmap the unaligned head and the remaining tail
+      size_t head = (huge_page_size - ((size_t)raw & (huge_page_size - 1))) & (huge_page_size - 1);
+
+      if (head)
+        munmap(raw, head);
+
+      munmap(raw + head + mapped, huge_page_size - head);
+
+      memory = raw + head;
+
+#ifdef MADV_HUGEPAGE
+      // ask for transparent huge pages
+      if (madvise(memory, mapped, MADV_HUGEPAGE) == 0)
+      {
+        fprintf(stderr, "info string %s: %zu KB on transparent huge pages\n", name, mapped / 1024);
+        return memory;
+      }
+#endif
+
+      fprintf(stderr, "info string %s: %zu KB on regular pages\n", name, mapped / 1024);
+
+      return memory;
+    }
+
+    // mapping failed, fall back to malloc() with the block kept off a huge page boundary
+    // (free_large() tells it from a mapping that way) and its start stored in front of it
+    raw = malloc(size + 64);
+
+    if (raw == NULL)
+      return NULL;
+
+    memory = raw + ((size_t)(raw + 32) & (huge_page_size - 1) ? 32 : 64);
+    ((char **)memory)[-1] = raw;
+
+    fprintf(stderr, "info string %s: %zu KB on regular pages\n", name, size / 1024);
+
+    return memory;
+  }
+#endif
+
+  fprintf(stderr, "info string %s: %zu KB on regular pages\n", name, size / 1024);
+
+  return malloc(size);
+}
+
+// release table allocated by allocate_large()
+void free_large(void *memory, size_t size)
+{
+#ifndef WIN64
+  if (size >= huge_page_size)
+  {
+    // mappings start on a huge page boundary, malloc() fallbacks don't
+    if (((size_t)memory & (huge_page_size - 1)) == 0)
+      munmap(memory, huge_page_round(size));
+    else
+      free(((char **)memory)[-1]);
+
+    return;
+  }
+#endif
+
+  free(memory);
+}
+
+/*
+ *
+ *                Zobrist Hashing
+ *
+ */
+
+// random number state the hash keys are generated from
+#define zobrist_seed 1804289383
+
+// random piece keys [piece][square]
+u64 piece_keys[12][64];
+
+// random enpassant keys [square]
+u64 enpassant_keys[64];
+
+// random castling keys
+u64 castle_keys[16];
+
+// random side key
+u64 side_key;
+
+// random plies left keys of the mate search node table [plies]
+u64 mate_depth_keys[64];
+
+/*
+ * Hash keys come from splitmix64 rather than the xorshift generator above.
+ * Xorshift is linear, so every key it yields is a linear function of its
+ * 32 bit state: all the keys span 32 dimensions and positions collide as if
+ * the keys were 32 bits wide.
+ */
+static inline u64 get_zobrist_key(u64 *state)
+{
+  u64 key = (*state += 0x9e3779b97f4a7c15ULL);
+
+  key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+
+  return key ^ (key >> 31);
+}
+
+// init random hash keys
+void init_random_keys()
+{
+  // update pseudo random number state
+  u64 state = zobrist_seed;
+
+  // loop over piece codes
+  for (int piece = P; piece <= k; piece++)
+  {
+    // loop over board squares
+    for (int square = 0; square < 64; square++)
+    {
+      // init random piece keys
+      piece_keys[piece][square] = get_zobrist_key(&state);
+    }
+  }
+
+  // loop over board squares
+  for (int square = 0; square < 64; square++)
+  {
+    // init random enpassant keys
+    enpassant_keys[square] = get_zobrist_key(&state);
+  }
+
+  // loop over castling keys
+  for (int index = 0; index < 16; index++)
+  {
+    // init castling keys
+    castle_keys[index] = get_zobrist_key(&state);
+  }
+
+  // init random side key
+  side_key = get_zobrist_key(&state);
+
+  // loop over plies left (drawn after the position keys, which stay as they were)
+  for (int plies = 0; plies < 64; plies++)
+  {
+    // init plies left keys
+    mate_depth_keys[plies] = get_zobrist_key(&state);
+  }
+}
+
+// generate "almost" unique position ID aka hash key from scratch
+u64 generate_hash_key()
+{
+  // final hash key
+  u64 final_key = 0ULL;
+
+  // temp piece bitboard copy
+  u64 bitboard;
+
+  // loop over piece bitboards
+  for (int piece = P; piece <= k; piece++)
+  {
+    bitboard = bitboards[piece];
+
+    // loop over the pieces within a bitboard
+    while (bitboard)
+    {
+      int square = get_lsb1st_index(bitboard);
+
+      // hash piece
+      final_key ^= piece_keys[piece][square];
+
+      pop_bit(bitboard, square);
+    }
+  }
+
+  // hash enpassant
+  if (enpassant != no_sq)
+  {
+    final_key ^= enpassant_keys[enpassant];
+  }
+
+  // hash castling rights
+  final_key ^= castle_keys[castle];
+
+  // hash the side only if black is to move
+  if (side == black)
+  {
+    final_key ^= side_key;
+  }
+
+  return final_key;
+}
+
+// generate pawn structure key from scratch
+u64 generate_pawn_key()
+{
+  u64 final_key = 0ULL;
+
+  // loop over white and black pawns
+  for (int piece = P; piece <= p; piece += p - P)
+  {
+    u64 bitboard = bitboards[piece];
+
+    while (bitboard)
+    {
+      int square = get_lsb1st_index(bitboard);
+
+      // hash pawn
+      final_key ^= piece_keys[piece][square];
+
+      pop_bit(bitboard, square);
+    }
+  }
+
+  return final_key;
+}
+
+void print_board()
+{
+  printf("\n");
+  for (int rank = 0; rank < 8; rank++)
+  {
+    for (int file = 0; file < 8; file++)
+    {
+      int square = rank * 8 + file;
+      if (!file)
+        printf("  %d  ", 8 - rank);
+
+      int piece = -1;
+      // loop over all piece bitboard
+      for (int bb_piece = P; bb_piece <= k; bb_piece++)
+      {
+        if (get_bit(bitboards[bb_piece], square))
+        {
+          piece = bb_piece;
+        }
+      }
+#ifdef WIN64
+      printf("%c ", (piece == -1) ? '.' : ascii_pieces[piece]);
+#else
+      printf("%s ", (piece == -1) ? "." : unicode_pieces[piece]);
+#endif
+    }
+    printf("\n");
+  }
+  printf("\n     A B C D E F G H \n\n");
+
+  printf("     Side to move  :    %s\n", (!side) ? "white" : "black");
+  printf("     Enpassant     :    %s\n", (enpassant != no_sq) ? square_to_coordinates[enpassant] : "no");
+  printf("     Castling      :    %c%c%c%c\n\n", (castle & wk) ? 'K' : '-', (castle & wq) ? 'Q' : '-', (castle & bk) ? 'k' : '-', (castle & bq) ? 'q' : '-');
+}
+
+// Parsing FEN string (returns 0 if the board, side or castling field is missing
+// or malformed, or a side doesn't have exactly one king: the position can't be searched then)
+int parse_fen(char *fen)
+{
+  // reset the position (bitboards)
+  memset(bitboards, 0ULL, sizeof(bitboards));
+  // reset the occupancies (bitboards)
+  memset(occupancies, 0ULL, sizeof(occupancies));
+  // reset game state variables
+  side = 0;
+  enpassant = no_sq;
+  castle = 0;
+  fifty = 0;
+
+  for (int rank = 0; rank < 8; rank++)
+  {
+    for (int file = 0; file < 8; file++)
+    {
+      int square = rank * 8 + file;
+
+      // matching ascii pieces of FEN string
+      if (*fen && memchr(ascii_pieces, *fen, sizeof(ascii_pieces)))
+      {
+        int piece = char_pieces[*fen];
+        set_bit(bitboards[piece], square);
+        fen++;
+      }
+      // matching empty square nunmber within FEN string
+      if (*fen >= '0' && *fen <= '9')
+      {
+        int offset = *fen - '0';
+
+        // on empty currrent square we want to decrement a file
+        int piece = -1;
+        for (int bb_piece = P; bb_piece <= k; bb_piece++)
+        {
+          if (get_bit(bitboards[bb_piece], square))
+            piece = bb_piece;
+        }
+
+        if (piece == -1)
+        {
+          file--;
+        }
+
+        file += offset;
+        fen++;
+      }
+      // matching rank separater
+      if (*fen == '/')
+      {
+        fen++;
+      }
+    }
+  }
+
+  // the board has to be followed by the side to move and the castling rights
+  int valid = fen[0] == ' ' && (fen[1] == 'w' || fen[1] == 'b') && fen[2] == ' ' && fen[3] && fen[3] != ' ';
+
+  // one king per side
+  valid = valid && count_bits(bitboards[K]) == 1 && count_bits(bitboards[k]) == 1;
+
+  // go to parse side to move
+  if (*fen)
+    fen++;
+  (*fen == 'w') ? (side = white) : (side = black);
+
+  // go to parse castling rights
+  if (*fen)
+    fen++;
+  if (*fen == ' ')
+    fen++;
+  while (*fen && *fen != ' ')
+  {
+    switch (*fen)
+    {
+    case 'K':
+      castle |= wk;
+      break;
+    case 'Q':
+      castle |= wq;
+      break;
+    case 'k':
+      castle |= bk;
+      break;
+    case 'q':
+      castle |= bq;
+      break;
+    case '-':
+      break;
+    }
+    fen++;
+  }
+
+  // go to parse enpassent square (optional in short EPD strings)
+  if (*fen == ' ')
+    fen++;
+  if (fen[0] >= 'a' && fen[0] <= 'h' && fen[1] >= '1' && fen[1] <= '8')
+  {
+    int file = fen[0] - 'a';
+    int rank = 8 - (fen[1] - '0');
+
+    enpassant = rank * 8 + file;
+  }
+  else
+  {
+    enpassant = no_sq;
+  }
+
+  // go to parse half move clock (optional, absent in EPD strings)
+  while (*fen && *fen != ' ')
+  {
+    fen++;
+  }
+  if (*fen == ' ')
+  {
+    fen++;
+  }
+  fifty = (*fen >= '0' && *fen <= '9') ? atoi(fen) : 0;
+
+  for (int piece = P; piece <= K; piece++)
+  {
+    // populate white occupancies
+    occupancies[white] |= bitboards[piece];
+  }
+  for (int piece = p; piece <= k; piece++)
+  {
+    // populate black occupancies
+    occupancies[black] |= bitboards[piece];
+  }
+
+  occupancies[both] |= occupancies[white];
+  occupancies[both] |= occupancies[black];
+
+  // init hash keys and reset repetitions
+  hash_key = generate_hash_key();
+  pawn_key = generate_pawn_key();
+  repetition_index = 0;
+
+  return valid;
+}
+
+// not A file
+/*
+ * 8   0 1 1 1 1 1 1 1
+ * 7   0 1 1 1 1 1 1 1
+ * 6   0 1 1 1 1 1 1 1
+ * 5   0 1 1 1 1 1 1 1
+ * 4   0 1 1 1 1 1 1 1
+ * 3   0 1 1 1 1 1 1 1
+ * 2   0 1 1 1 1 1 1 1
+ * 1   0 1 1 1 1 1 1 1
+ *
+ *    A B C D E F G H
+ */
+const u64 not_a_file = 18374403900871474942ULL;
+
+// not H file
+/*
+ * 8   1 1 1 1 1 1 1 0
+ * 7   1 1 1 1 1 1 1 0
+ * 6   1 1 1 1 1 1 1 0
+ * 5   1 1 1 1 1 1 1 0
+ * 4   1 1 1 1 1 1 1 0
+ * 3   1 1 1 1 1 1 1 0
+ * 2   1 1 1 1 1 1 1 0
+ * 1   1 1 1 1 1 1 1 0
+ *    A B C D E F G H
+ */
+const u64 not_h_file = 9187201950435737471ULL;
+
+// not HG file
+/*
+ * 8   1 1 1 1 1 1 0 0
+ * 7   1 1 1 1 1 1 0 0
+ * 6   1 1 1 1 1 1 0 0
+ * 5   1 1 1 1 1 1 0 0
+ * 4   1 1 1 1 1 1 0 0
+ * 3   1 1 1 1 1 1 0 0
+ * 2   1 1 1 1 1 1 0 0
+ * 1   1 1 1 1 1 1 0 0
+ *
+ * A B C D E F G H
+ */
+const u64 not_hg_file = 4557430888798830399ULL;
+
+// not AB file
+/*
+ * 8   0 0 1 1 1 1 1 1
+ * 7   0 0 1 1 1 1 1 1
+ * 6   0 0 1 1 1 1 1 1
+ * 5   0 0 1 1 1 1 1 1
+ * 4   0 0 1 1 1 1 1 1
+ * 3   0 0 1 1 1 1 1 1
+ * 2   0 0 1 1 1 1 1 1
+ * 1   0 0 1 1 1 1 1 1
+ *
+ *    A B C D E F G H
+ */
+const u64 not_ab_file = 18229723555195321596ULL;
+
+// bishop relevant ocuupancy bit count for every square on board
+const int bishop_relevant_bits[64] = {
+    6, 5, 5, 5, 5, 5, 5, 6,
+    5, 5, 5, 5, 5, 5, 5, 5,
+    5, 5, 7, 7, 7, 7, 5, 5,
+    5, 5, 7, 9, 9, 7, 5, 5,
+    5, 5, 7, 9, 9, 7, 5, 5,
+    5, 5, 7, 7, 7, 7, 5, 5,
+    5, 5, 5, 5, 5, 5, 5, 5,
+    6, 5, 5, 5, 5, 5, 5, 6};
+
+// rook relevant ocuupancy bit count for every square on board
+const int rook_relevant_bits[64] = {
+    12, 11, 11, 11, 11, 11, 11, 12,
+    11, 10, 10, 10, 10, 10, 10, 11,
+    11, 10, 10, 10, 10, 10, 10, 11,
+    11, 10, 10, 10, 10, 10, 10, 11,
+    11, 10, 10, 10, 10, 10, 10, 11,
+    11, 10, 10, 10, 10, 10, 10, 11,
+    11, 10, 10, 10, 10, 10, 10, 11,
+    12, 11, 11, 11, 11, 11, 11, 12};
+
+// rook magic numbers
+u64 rook_magic_numbers[64] = {
+    0x8a80104000800020ULL,
+    0x140002000100040ULL,
+    0x2801880a0017001ULL,
+    0x100081001000420ULL,
+    0x200020010080420ULL,
+    0x3001c0002010008ULL,
+    0x8480008002000100ULL,
+    0x2080088004402900ULL,
+    0x800098204000ULL,
+    0x2024401000200040ULL,
+    0x100802000801000ULL,
+    0x120800800801000ULL,
+    0x208808088000400ULL,
+    0x2802200800400ULL,
+    0x2200800100020080ULL,
+    0x801000060821100ULL,
+    0x80044006422000ULL,
+    0x100808020004000ULL,
+    0x12108a0010204200ULL,
+    0x140848010000802ULL,
+    0x481828014002800ULL,
+    0x8094004002004100ULL,
+    0x4010040010010802ULL,
+    0x20008806104ULL,
+    0x100400080208000ULL,
+    0x2040002120081000ULL,
+    0x21200680100081ULL,
+    0x20100080080080ULL,
+    0x2000a00200410ULL,
+    0x20080800400ULL,
+    0x80088400100102ULL,
+    0x80004600042881ULL,
+    0x4040008040800020ULL,
+    0x440003000200801ULL,
+    0x4200011004500ULL,
+    0x188020010100100ULL,
+    0x14800401802800ULL,
+    0x2080040080800200ULL,
+    0x124080204001001ULL,
+    0x200046502000484ULL,
+    0x480400080088020ULL,
+    0x1000422010034000ULL,
+    0x30200100110040ULL,
+    0x100021010009ULL,
+    0x2002080100110004ULL,
+    0x202008004008002ULL,
+    0x20020004010100ULL,
+    0x2048440040820001ULL,
+    0x101002200408200ULL,
+    0x40802000401080ULL,
+    0x4008142004410100ULL,
+    0x2060820c0120200ULL,
+    0x1001004080100ULL,
+    0x20c020080040080ULL,
+    0x2935610830022400ULL,
+    0x44440041009200ULL,
+    0x280001040802101ULL,
+    0x2100190040002085ULL,
+    0x80c0084100102001ULL,
+    0x4024081001000421ULL,
+    0x20030a0244872ULL,
+    0x12001008414402ULL,
+    0x2006104900a0804ULL,
+    0x1004081002402ULL};
+
+// bishop magic numbers
+u64 bishop_magic_numbers[64] = {
+    0x40040844404084ULL,
+    0x2004208a004208ULL,
+    0x10190041080202ULL,
+    0x108060845042010ULL,
+    0x581104180800210ULL,
+    0x2112080446200010ULL,
+    0x1080820820060210ULL,
+    0x3c0808410220200ULL,
+    0x4050404440404ULL,
+    0x21001420088ULL,
+    0x24d0080801082102ULL,
+    0x1020a0a020400ULL,
+    0x40308200402ULL,
+    0x4011002100800ULL,
+    0x401484104104005ULL,
+    0x801010402020200ULL,
+    0x400210c3880100ULL,
+    0x404022024108200ULL,
+    0x810018200204102ULL,
+    0x4002801a02003ULL,
+    0x85040820080400ULL,
+    0x810102c808880400ULL,
+    0xe900410884800ULL,
+    0x8002020480840102ULL,
+    0x220200865090201ULL,
+    0x2010100a02021202ULL,
+    0x152048408022401ULL,
+    0x20080002081110ULL,
+    0x4001001021004000ULL,
+    0x800040400a011002ULL,
+    0xe4004081011002ULL,
+    0x1c004001012080ULL,
+    0x8004200962a00220ULL,
+    0x8422100208500202ULL,
+    0x2000402200300c08ULL,
+    0x8646020080080080ULL,
+    0x80020a0200100808ULL,
+    0x2010004880111000ULL,
+    0x623000a080011400ULL,
+    0x42008c0340209202ULL,
+    0x209188240001000ULL,
+    0x400408a884001800ULL,
+    0x110400a6080400ULL,
+    0x1840060a44020800ULL,
+    0x90080104000041ULL,
+    0x201011000808101ULL,
+    0x1a2208080504f080ULL,
+    0x8012020600211212ULL,
+    0x500861011240000ULL,
+    0x180806108200800ULL,
+    0x4000020e01040044ULL,
+    0x300000261044000aULL,
+    0x802241102020002ULL,
+    0x20906061210001ULL,
+    0x5a84841004010310ULL,
+    0x4010801011c04ULL,
+    0xa010109502200ULL,
+    0x4a02012000ULL,
+    0x500201010098b028ULL,
+    0x8040002811040900ULL,
+    0x28000010020204ULL,
+    0x6000020202d0240ULL,
+    0x8918844842082200ULL,
+    0x4010011029020020ULL};
+
+u64 pawn_attacks[2][64];
+u64 knight_attacks[64];
+u64 king_attacks[64];
+u64 bishop_masks[64];
+u64 rook_masks[64];
+// bishop attack tables [square][occupancies] (256 KB)
+u64 (*bishop_attacks)[512];
+// rook attack tables [square][occupancies] (2 MB)
+u64 (*rook_attacks)[4096];
+
+// generate pawn attacks
+u64 mask_pawn_attacks(int side, int square)
+{
+  u64 attacks = 0ULL;
+  u64 bitboard = 0ULL;
+  set_bit(bitboard, square);
+
+  if (side == 0) // white
+  {
+    if ((bitboard >> 7) & not_a_file)
+      attacks |= (bitboard >> 7);
+    if ((bitboard >> 9) & not_h_file)
+      attacks |= (bitboard >> 9);
+  }
+  else // black
+  {
+    if ((bitboard << 7) & not_h_file)
+      attacks |= (bitboard << 7);
+    if ((bitboard << 9) & not_a_file)
+      attacks |= (bitboard << 9);
+  }
+
+  return attacks;
+}
+
+// generate knight attacks
+u64 mask_knight_attacks(int square)
+{
+  u64 attacks = 0ULL;
+  u64 bitboard = 0ULL;
+  set_bit(bitboard, square);
+  // print_bitboard(bitboard);
+
+  if ((bitboard >> 17) & not_h_file)
+    attacks |= (bitboard >> 17);
+  if ((bitboard) >> 15 & not_a_file)
+    attacks |= (bitboard >> 15);
+  if ((bitboard >> 10) & not_hg_file)
+    attacks |= (bitboard >> 10);
+  if ((bitboard >> 6) & not_ab_file)
+    attacks |= (bitboard >> 6);
+
+  if ((bitboard << 17 & not_a_file))
+    attacks |= (bitboard << 17);
+  if ((bitboard) << 15 & not_h_file)
+    attacks |= (bitboard << 15);
+  if ((bitboard << 10) & not_ab_file)
+    attacks |= (bitboard << 10);
+  if ((bitboard << 6) & not_hg_file)
+    attacks |= (bitboard << 6);
+
+  return attacks;
+}
+
+// generate king attacks
+u64 mask_king_attacks(int square)
+{
+  u64 attacks = 0ULL;
+  u64 bitboard = 0ULL;
+  set_bit(bitboard, square);
+  // print_bitboard(bitboard);
+  if (bitboard >> 8)
+    attacks |= (bitboard >> 8);
+  if (bitboard << 8)
+    attacks |= (bitboard << 8);
+  if ((bitboard >> 9) & not_h_file)
+    attacks |= (bitboard >> 9);
+  if ((bitboard >> 7) & not_a_file)
+    attacks |= (bitboard >> 7);
+  if ((bitboard << 9) & not_a_file)
+    attacks |= (bitboard << 9);
+  if ((bitboard << 7) & not_h_file)
+    attacks |= (bitboard << 7);
+  if ((bitboard << 1) & not_a_file)
+    attacks |= (bitboard << 1);
+  if ((bitboard >> 1) & not_h_file)
+    attacks |= (bitboard >> 1);
+
+  return attacks;
+}
+
+// mask bishop attacks
+u64 mask_bishop_attacks(int square)
+{
+  u64 attacks = 0ULL;
+  int r, f;
+  int tr = square / 8;
+  int tf = square % 8;
+
+  for (r = tr + 1, f = tf + 1; r <= 6 && f <= 6; r++, f++)
+    attacks |= (1ULL << (r * 8 + f));
+
+  for (r = tr - 1, f = tf - 1; r >= 1 && f >= 1; r--, f--)
+    attacks |= (1ULL << (r * 8 + f));
+
+  for (r = tr + 1, f = tf - 1; r <= 6 && f >= 1; r++, f--)
+    attacks |= (1ULL << (r * 8 + f));
+
+  for (r = tr - 1, f = tf + 1; r >= 1 && f <= 6; r--, f++)
+    attacks |= (1ULL << (r * 8 + f));
+
+  return attacks;
+}
+
+// mask rook attacks
+u64 mask_rook_attacks(int square)
+{
+  u64 attacks = 0ULL;
+  int r, f;
+  int tr = square / 8;
+  int tf = square % 8;
+
+  for (int r = tr + 1; r <= 6; r++)
+    attacks |= (1ULL << (r * 8 + tf));
+  for (int r = tr - 1; r >= 1; r--)
+    attacks |= (1ULL << (r * 8 + tf));
+  for (int f = tf + 1; f <= 6; f++)
+    attacks |= (1ULL << (tr * 8 + f));
+  for (int f = tf - 1; f >= 1; f--)
+    attacks |= (1ULL << (tr * 8 + f));
+
+  return attacks;
+}
+
+// generate bishop attacks on fly
+u64 bishop_attacks_on_the_fly(int square, u64 block)
+{
+  u64 attacks = 0ULL;
+  int r, f;
+  int tr = square / 8;
+  int tf = square % 8;
+
+  for (r = tr + 1, f = tf + 1; r <= 7 && f <= 7; r++, f++)
+  {
+    attacks |= (1ULL << (r * 8 + f));
+    if ((1ULL << (r * 8 + f)) & block)
+      break;
+  }
+
+  for (r = tr - 1, f = tf - 1; r >= 0 && f >= 0; r--, f--)
+  {
+    attacks |= (1ULL << (r * 8 + f));
+    if ((1ULL << (r * 8 + f)) & block)
+      break;
+  }
+
+  for (r = tr + 1, f = tf - 1; r <= 7 && f >= 0; r++, f--)
+  {
+    attacks |= (1ULL << (r * 8 + f));
+    if ((1ULL << (r * 8 + f)) & block)
+      break;
+  }
+
+  for (r = tr - 1, f = tf + 1; r >= 0 && f <= 7; r--, f++)
+  {
+    attacks |= (1ULL << (r * 8 + f));
+    if ((1ULL << (r * 8 + f)) & block)
+      break;
+  }
+
+  return attacks;
+}
+
+// generate rook attacks on fly
+u64 rook_attacks_on_the_fly(int square, u64 block)
+{
+  u64 attacks = 0ULL;
+  int r, f;
+  int tr = square / 8;
+  int tf = square % 8;
+
+  for (int r = tr + 1; r <= 7; r++)
+  {
+    attacks |= (1ULL << (r * 8 + tf));
+    if ((1ULL << (r * 8 + tf)) & block)
+      break;
+  }
+  for (int r = tr - 1; r >= 0; r--)
+  {
+    attacks |= (1ULL << (r * 8 + tf));
+    if ((1ULL << (r * 8 + tf)) & block)
+      break;
+  }
+  for (int f = tf + 1; f <= 7; f++)
+  {
+    attacks |= (1ULL << (tr * 8 + f));
+    if ((1ULL << (tr * 8 + f)) & block)
+      break;
+  }
+  for (int f = tf - 1; f >= 0; f--)
+  {
+    attacks |= (1ULL << (tr * 8 + f));
+    if ((1ULL << (tr * 8 + f)) & block)
+      break;
+  }
+
+  return attacks;
+}
+
+// set occupancies
+u64 set_occupancy(int index, int bits_in_mask, u64 attack_mask)
+{
+  u64 occupancy = 0ULL;
+
+  for (int count = 0; count < bits_in_mask; count++)
+  {
+    int square = get_lsb1st_index(attack_mask);
+    pop_bit(attack_mask, square);
+
+    if (index & (1ULL << count))
+    {
+      occupancy |= (1ULL << square);
+    }
+  }
+
+  return occupancy;
+}
+
+// init leaper pieces attacks
+void init_leapers_attacks()
+{
+  for (int sq = 0; sq < 64; sq++)
+  {
+    pawn_attacks[white][sq] = mask_pawn_attacks(white, sq);
+    pawn_attacks[black][sq] = mask_pawn_attacks(black, sq);
+
+    knight_attacks[sq] = mask_knight_attacks(sq);
+
+    king_attacks[sq] = mask_king_attacks(sq);
+  }
+}
+
+// finding magic numbers
+u64 find_magic_number(int square, int relevant_bits, int bishop)
+{
+  // 96 KB of scratch tables, kept off the stack (only used during single threaded init)
+  static u64 occupancies[4096];
+
+  static u64 attacks[4096];
+
+  static u64 used_attacks[4096];
+
+  u64 attack_mask = bishop ? mask_bishop_attacks(square) : mask_rook_attacks(square);
+
+  int occupancy_indices = 1 << relevant_bits;
+
+  for (int index = 0; index < occupancy_indices; index++)
+  {
+    occupancies[index] = set_occupancy(index, relevant_bits, attack_mask);
+    attacks[index] = bishop ? bishop_attacks_on_the_fly(square, occupancies[index]) : rook_attacks_on_the_fly(square, occupancies[index]);
+  }
+
+  // test magic loop
+  for (int random_count = 0; random_count < 100000000; random_count++)
+  {
+    // generate magic number candidate
+    u64 magic_number = generate_magic_number();
+
+    // skip inappropiate magic numbers
+    if (count_bits((attack_mask * magic_number) & 0xFF00000000000000) < 6)
+    {
+      continue;
+    }
+
+    // init used_attacks
+    memset(used_attacks, 0ULL, sizeof(used_attacks));
+
+    // init index & fail flag
+    int index, fail;
+
+    // test magic index loop
+    for (index = 0, fail = 0; !fail && index < occupancy_indices; index++)
+    {
+      int magic_index = (int)((occupancies[index] * magic_number) >> (64 - relevant_bits));
+
+      // if magic index works
+      if (used_attacks[magic_index] == 0ULL)
+      {
+        used_attacks[magic_index] = attacks[index];
+      }
+      else if (used_attacks[magic_index] != attacks[index])
+      {
+        fail = 1;
+      }
+    }
+
+    if (!fail)
+    {
+      return magic_number;
+    }
+  }
+  printf("    Magic number fails");
+  return 0ULL;
+}
+
+// init magic numbers
+void init_magic_numbers()
+{
+  for (int square = 0; square < 64; square++)
+  {
+    // init rook magic number
+    rook_magic_numbers[square] = find_magic_number(square, rook_relevant_bits[square], rook);
+  }
+
+  printf("\n\n");
+
+  for (int square = 0; square < 64; square++)
+  {
+    // init bishop magic number
+    bishop_magic_numbers[square] = find_magic_number(square, bishop_relevant_bits[square], bishop);
+  }
+}
+
+// init slider peices attack tables
+void init_sliders_attacks(int bishop)
+{
+  // allocate attack tables
+  if (bishop)
+    bishop_attacks = allocate_large(64 * sizeof(*bishop_attacks), "bishop attacks");
+  else
+    rook_attacks = allocate_large(64 * sizeof(*rook_attacks), "rook attacks");
+
+  // the engine can't run without them
+  if ((bishop && bishop_attacks == NULL) || (!bishop && rook_attacks == NULL))
+  {
+    fprintf(stderr, "Couldn't allocate memory for slider attack tables\n");
+    exit(1);
+  }
+
+  for (int square = 0; square < 64; square++)
+  {
+    bishop_masks[square] = mask_bishop_attacks(square);
+    rook_masks[square] = mask_rook_attacks(square);
+
+    // init current mask
+    u64 attack_mask = bishop ? bishop_masks[square] : rook_masks[square];
+
+    // init relevant occupancy bit count
+    int relevant_bits_count = count_bits(attack_mask);
+
+    // init occupancies
+    int occupancy_indices = (1 << relevant_bits_count);
+
+    for (int index = 0; index < occupancy_indices; index++)
+    {
+      if (bishop)
+      {
+        // init current occupancy variation
+        u64 occupancy = set_occupancy(index, relevant_bits_count, attack_mask);
+
+        // init magic index
+        int magic_index = (occupancy * bishop_magic_numbers[square]) >> (64 - bishop_relevant_bits[square]);
+
+        // init bishop attacks
+        bishop_attacks[square][magic_index] = bishop_attacks_on_the_fly(square, occupancy);
+      }
+      else
+      {
+        // init current occupancy variation
+        u64 occupancy = set_occupancy(index, relevant_bits_count, attack_mask);
+
+        // init magic index
+        int magic_index = (occupancy * rook_magic_numbers[square]) >> (64 - rook_relevant_bits[square]);
+
+        // init bishop attacks
+        rook_attacks[square][magic_index] = rook_attacks_on_the_fly(square, occupancy);
+      }
+    }
+  }
+}
+
+static inline u64 get_bishop_attacks(int square, u64 occupancy)
+{
+  // get bishop attacks assuming current board occupancy
+  occupancy &= bishop_masks[square];
+  occupancy *= bishop_magic_numbers[square];
+  occupancy >>= (64 - bishop_relevant_bits[square]);
+
+  return bishop_attacks[square][occupancy];
+}
+
+static inline u64 get_queen_attacks(int square, u64 occupancy)
+{
+  // init result attack bitboard
+  u64 queen_attacks = 0ULL;
+  // intit bishop occupancies
+  u64 bishop_occupancy = occupancy;
+  // intit rook occupancies
+  u64 rook_occupancy = occupancy;
+
+  // get bishop attacks assuming current board occupancy
+  bishop_occupancy &= bishop_masks[square];
+  bishop_occupancy *= bishop_magic_numbers[square];
+  bishop_occupancy >>= (64 - bishop_relevant_bits[square]);
+
+  queen_attacks = bishop_attacks[square][bishop_occupancy];
+
+  // get rook attacks assuming current board occupancy
+  rook_occupancy &= rook_masks[square];
+  rook_occupancy *= rook_magic_numbers[square];
+  rook_occupancy >>= (64 - rook_relevant_bits[square]);
+
+  queen_attacks |= rook_attacks[square][rook_occupancy];
+
+  return queen_attacks;
+}
+
+static inline u64 get_rook_attacks(int square, u64 occupancy)
+{
+  // get rook attacks assuming current board occupancy
+  occupancy &= rook_masks[square];
+  occupancy *= rook_magic_numbers[square];
+  occupancy >>= (64 - rook_relevant_bits[square]);
+
+  return rook_attacks[square][occupancy];
+}
+
+/*
+ *
+ *                Statistics
+ *
+ *  Compile with -DSTATS to count what the hot paths do (make stats),
+ *  add -DSTATS_RDTSC to also sample the cycles spent in generate_moves,
+ *  make_move and is_square_attacked (make stats-rdtsc). Without STATS
+ *  every hook below expands to nothing.
+ *
+ */
+
+#ifdef STATS
+
+#ifdef STATS_RDTSC
+#include <x86intrin.h>
+#endif
+
+// sampled functions
+enum
+{
+  timer_generate_moves,
+  timer_make_move,
+  timer_is_square_attacked
+};
+
+// hot path counters
+typedef struct
+{
+  long moves_generated[12];    // pseudo legal moves per moving piece
+  long moves_made;             // make_move calls (all moves)
+  long moves_rejected;         // moves leaving the king in check
+  long attack_queries;         // is_square_attacked calls
+  long castling_queries;       // is_square_attacked calls made by castling checks
+  long tt_probes;              // hash table probes
+  long tt_hits;                // probes with a matching key
+  long beta_cutoffs;           // fail-high nodes
+  long first_move_cutoffs;     // fail-high on the first move searched
+  long check_extensions;       // checking moves searched one ply deeper
+  long singular_extensions;    // hash moves found singular and searched one ply deeper
+  long recapture_extensions;   // recaptures searched one ply deeper
+  long probcut_cutoffs;        // nodes cut by a capture beating beta by the ProbCut margin
+  long calls[3];               // calls of every sampled function
+  long samples[3];             // calls actually timed
+  unsigned long long cycles[3]; // cycles spent in the timed calls
+} engine_stats;
+
+// counters are per thread so workers never share cache lines
+__thread engine_stats stats;
+
+// sample one call out of 64
+#define stats_sample_mask 63
+
+#define stats_inc(counter) (stats.counter++)
+
+#define reset_stats() memset(&stats, 0, sizeof(stats))
+
+#ifdef STATS_RDTSC
+// time every 64th call of a function returning a value
+#define stats_sample(timer, call)                           \
+  ({                                                        \
+    __typeof__(call) sample_result;                         \
+    if ((stats.calls[timer]++ & stats_sample_mask) == 0)    \
+    {                                                       \
+      unsigned long long sample_start = __rdtsc();          \
+      sample_result = call;                                 \
+      stats.cycles[timer] += __rdtsc() - sample_start;      \
+      stats.samples[timer]++;                               \
+    }                                                       \
+    else                                                    \
+      sample_result = call;                                 \
+    sample_result;                                          \
+  })
+
+// time every 64th call of a void function
+#define stats_sample_void(timer, call)                      \
+  do                                                        \
+  {                                                         \
+    if ((stats.calls[timer]++ & stats_sample_mask) == 0)    \
+    {                                                       \
+      unsigned long long sample_start = __rdtsc();          \
+      call;                                                 \
+      stats.cycles[timer] += __rdtsc() - sample_start;      \
+      stats.samples[timer]++;                               \
+    }                                                       \
+    else                                                    \
+      call;                                                 \
+  } while (0)
+#endif
+
+// print counters gathered by the current thread (to stderr, away from the UCI stream)
+void print_stats()
+{
+  char *piece_names[6] = {"pawn", "knight", "bishop", "rook", "queen", "king"};
+  char *timer_names[3] = {"generate_moves", "make_move", "is_square_attacked"};
+
+  long generated = 0;
+
+  fprintf(stderr, "\n     Stats\n\n");
+
+  for (int piece = P; piece <= K; piece++)
+  {
+    long count = stats.moves_generated[piece] + stats.moves_generated[piece + 6];
+    generated += count;
+    fprintf(stderr, "     Moves generated (%s): %ld\n", piece_names[piece], count);
+  }
+
+  fprintf(stderr, "     Moves generated: %ld\n", generated);
+  fprintf(stderr, "     Moves made: %ld\n", stats.moves_made);
+  fprintf(stderr, "     Moves rejected (king in check): %ld (%.2f%%)\n", stats.moves_rejected, stats.moves_made ? 100.0 * stats.moves_rejected / stats.moves_made : 0.0);
+  fprintf(stderr, "     Attack queries: %ld (castling %ld)\n", stats.attack_queries, stats.castling_queries);
+  fprintf(stderr, "     TT probes: %ld hits: %ld (%.2f%%)\n", stats.tt_probes, stats.tt_hits, stats.tt_probes ? 100.0 * stats.tt_hits / stats.tt_probes : 0.0);
+  fprintf(stderr, "     Beta cutoffs: %ld first move: %ld (%.2f%%)\n", stats.beta_cutoffs, stats.first_move_cutoffs, stats.beta_cutoffs ? 100.0 * stats.first_move_cutoffs / stats.beta_cutoffs : 0.0);
+  fprintf(stderr, "     Extensions: check %ld singular %ld recapture %ld\n", stats.check_extensions, stats.singular_extensions, stats.recapture_extensions);
+  fprintf(stderr, "     ProbCut cutoffs: %ld\n", stats.probcut_cutoffs);
+
+  for (int timer = 0; timer < 3; timer++)
+  {
+    if (stats.samples[timer])
+    {
+      double per_call = (double)stats.cycles[timer] / stats.samples[timer];
+      fprintf(stderr, "     Cycles %s: %.1f per call, %.0f total (est.)\n", timer_names[timer], per_call, per_call * stats.calls[timer]);
+    }
+  }
+
+  fprintf(stderr, "\n");
+}
+
+#else
+
+#define stats_inc(counter) ((void)0)
+#define reset_stats() ((void)0)
+#define print_stats() ((void)0)
+
+#endif
+
+// castling square safety check (counted separately from the other attack queries)
+#define is_castling_square_attacked(square, side) (stats_inc(castling_queries), is_square_attacked(square, side))
+
+/*
+ *
+ *                Attack Maps
+ *
+ *  Builds the bitboard of all squares a side attacks in one pass instead of
+ *  64 is_square_attacked() queries. Pawns and knights are shifted as whole
+ *  sets, sliders are flood filled along each ray with Kogge-Stone occluded
+ *  fills (3 shift steps per ray instead of one step per square):
+ *
+ *    AVX2     4 ray directions per vector (variable per lane shifts)
+ *    SSE2     white and black rays in the 2 lanes of a vector
+ *    scalar   one ray at a time
+ *
+ *  The widest instruction set the compiler targets is used (make avx2).
+ *
+ */
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// ray shifts towards higher square indices: south, east, south-east, south-west
+// and towards lower square indices: north, west, north-west, north-east
+#define ray_shift_south 8
+#define ray_shift_east 1
+#define ray_shift_south_east 9
+#define ray_shift_south_west 7
+
+#if defined(__AVX2__)
+
+// slider attacks of both sides [side], rooks/bishops include queens
+static inline void slider_attack_maps(u64 rooks[2], u64 bishops[2], u64 empty, u64 attacks[2])
+{
+  // lane shifts and wrap masks: south, east, south-east, south-west (mirrored for the right fills)
+  const __m256i shift = _mm256_setr_epi64x(ray_shift_south, ray_shift_east, ray_shift_south_east, ray_shift_south_west);
+  const __m256i wrap_left = _mm256_setr_epi64x(~0ULL, not_a_file, not_a_file, not_h_file);
+  const __m256i wrap_right = _mm256_setr_epi64x(~0ULL, not_h_file, not_h_file, not_a_file);
+
+  // doubled shifts for the 2 and 4 step stages
+  const __m256i shift2 = _mm256_add_epi64(shift, shift);
+  const __m256i shift4 = _mm256_add_epi64(shift2, shift2);
+
+  for (int color = white; color <= black; color++)
+  {
+    // rook rays in lanes 0-1, bishop rays in lanes 2-3
+    __m256i sliders = _mm256_setr_epi64x(rooks[color], rooks[color], bishops[color], bishops[color]);
+
+    // fill towards higher square indices
+    __m256i gen = sliders;
+    __m256i vacant = _mm256_and_si256(_mm256_set1_epi64x(empty), wrap_left);
+    gen = _mm256_or_si256(gen, _mm256_and_si256(vacant, _mm256_sllv_epi64(gen, shift)));
+    vacant = _mm256_and_si256(vacant, _mm256_sllv_epi64(vacant, shift));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(vacant, _mm256_sllv_epi64(gen, shift2)));
+    vacant = _mm256_and_si256(vacant, _mm256_sllv_epi64(vacant, shift2));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(vacant, _mm256_sllv_epi64(gen, shift4)));
+    __m256i left = _mm256_and_si256(_mm256_sllv_epi64(gen, shift), wrap_left);
+
+    // fill towards lower square indices
+    gen = sliders;
+    vacant = _mm256_and_si256(_mm256_set1_epi64x(empty), wrap_right);
+    gen = _mm256_or_si256(gen, _mm256_and_si256(vacant, _mm256_srlv_epi64(gen, shift)));
+    vacant = _mm256_and_si256(vacant, _mm256_srlv_epi64(vacant, shift));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(vacant, _mm256_srlv_epi64(gen, shift2)));
+    vacant = _mm256_and_si256(vacant, _mm256_srlv_epi64(vacant, shift2));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(vacant, _mm256_srlv_epi64(gen, shift4)));
+    __m256i right = _mm256_and_si256(_mm256_srlv_epi64(gen, shift), wrap_right);
+
+    // merge the 8 rays
+    __m256i rays = _mm256_or_si256(left, right);
+    __m128i half = _mm_or_si128(_mm256_castsi256_si128(rays), _mm256_extracti128_si256(rays, 1));
+    attacks[color] = _mm_cvtsi128_si64(_mm_or_si128(half, _mm_unpackhi_epi64(half, half)));
+  }
+}
+
+#elif defined(__SSE2__)
+
+// occluded fill of white (lane 0) and black (lane 1) sliders towards higher square indices
+static inline __m128i ray_fill_left_sse2(__m128i sliders, __m128i empty, int shift, u64 wrap)
+{
+  __m128i mask = _mm_set1_epi64x(wrap);
+  __m128i step1 = _mm_cvtsi32_si128(shift);
+  __m128i step2 = _mm_cvtsi32_si128(shift * 2);
+  __m128i step4 = _mm_cvtsi32_si128(shift * 4);
+
+  empty = _mm_and_si128(empty, mask);
+  sliders = _mm_or_si128(sliders, _mm_and_si128(empty, _mm_sll_epi64(sliders, step1)));
+  empty = _mm_and_si128(empty, _mm_sll_epi64(empty, step1));
+  sliders = _mm_or_si128(sliders, _mm_and_si128(empty, _mm_sll_epi64(sliders, step2)));
+  empty = _mm_and_si128(empty, _mm_sll_epi64(empty, step2));
+  sliders = _mm_or_si128(sliders, _mm_and_si128(empty, _mm_sll_epi64(sliders, step4)));
+
+  return _mm_and_si128(_mm_sll_epi64(sliders, step1), mask);
+}
+
+// occluded fill of white (lane 0) and black (lane 1) sliders towards lower square indices
+static inline __m128i ray_fill_right_sse2(__m128i sliders, __m128i empty, int shift, u64 wrap)
+{
+  __m128i mask = _mm_set1_epi64x(wrap);
+  __m128i step1 = _mm_cvtsi32_si128(shift);
+  __m128i step2 = _mm_cvtsi32_si128(shift * 2);
+  __m128i step4 = _mm_cvtsi32_si128(shift * 4);
+
+  empty = _mm_and_si128(empty, mask);
+  sliders = _mm_or_si128(sliders, _mm_and_si128(empty, _mm_srl_epi64(sliders, step1)));
+  empty = _mm_and_si128(empty, _mm_srl_epi64(empty, step1));
+  sliders = _mm_or_si128(sliders, _mm_and_si128(empty, _mm_srl_epi64(sliders, step2)));
+  empty = _mm_and_si128(empty, _mm_srl_epi64(empty, step2));
+  sliders = _mm_or_si128(sliders, _mm_and_si128(empty, _mm_srl_epi64(sliders, step4)));
+
+  return _mm_and_si128(_mm_srl_epi64(sliders, step1), mask);
+}
+
+// slider attacks of both sides [side], rooks/bishops include queens
+static inline void slider_attack_maps(u64 rooks[2], u64 bishops[2], u64 empty, u64 attacks[2])
+{
+  // white sliders in lane 0, black sliders in lane 1
+  __m128i rook_lanes = _mm_set_epi64x(rooks[black], rooks[white]);
+  __m128i bishop_lanes = _mm_set_epi64x(bishops[black], bishops[white]);
+  __m128i vacant = _mm_set1_epi64x(empty);
+
+  // rook rays
+  __m128i rays = ray_fill_left_sse2(rook_lanes, vacant, ray_shift_south, ~0ULL);
+  rays = _mm_or_si128(rays, ray_fill_left_sse2(rook_lanes, vacant, ray_shift_east, not_a_file));
+  rays = _mm_or_si128(rays, ray_fill_right_sse2(rook_lanes, vacant, ray_shift_south, ~0ULL));
+  rays = _mm_or_si128(rays, ray_fill_right_sse2(rook_lanes, vacant, ray_shift_east, not_h_file));
+
+  // bishop rays
+  rays = _mm_or_si128(rays, ray_fill_left_sse2(bishop_lanes, vacant, ray_shift_south_east, not_a_file));
+  rays = _mm_or_si128(rays, ray_fill_left_sse2(bishop_lanes, vacant, ray_shift_south_west, not_h_file));
+  rays = _mm_or_si128(rays, ray_fill_right_sse2(bishop_lanes, vacant, ray_shift_south_east, not_h_file));
+  rays = _mm_or_si128(rays, ray_fill_right_sse2(bishop_lanes, vacant, ray_shift_south_west, not_a_file));
+
+  attacks[white] = _mm_cvtsi128_si64(rays);
+  attacks[black] = _mm_cvtsi128_si64(_mm_unpackhi_epi64(rays, rays));
+}
+
+#else
+
+// occluded fill towards higher square indices, returns attacked squares (blockers included)
+static inline u64 ray_fill_left(u64 sliders, u64 empty, int shift, u64 wrap)
+{
+  // squares a ray may enter without wrapping around the board edge
+  empty &= wrap;
+
+  // spread sliders 1, 2 and 4 steps through empty squares
+  sliders |= empty & (sliders << shift);
+  empty &= empty << shift;
+  sliders |= empty & (sliders << (shift * 2));
+  empty &= empty << (shift * 2);
+  sliders |= empty & (sliders << (shift * 4));
+
+  // one more step hits the blocker
+  return (sliders << shift) & wrap;
+}
+
+// occluded fill towards lower square indices
+static inline u64 ray_fill_right(u64 sliders, u64 empty, int shift, u64 wrap)
+{
+  empty &= wrap;
+
+  sliders |= empty & (sliders >> shift);
+  empty &= empty >> shift;
+  sliders |= empty & (sliders >> (shift * 2));
+  empty &= empty >> (shift * 2);
+  sliders |= empty & (sliders >> (shift * 4));
+
+  return (sliders >> shift) & wrap;
+}
+
+// slider attacks of both sides [side], rooks/bishops include queens
+static inline void slider_attack_maps(u64 rooks[2], u64 bishops[2], u64 empty, u64 attacks[2])
+{
+  for (int color = white; color <= black; color++)
+  {
+    attacks[color] = ray_fill_left(rooks[color], empty, ray_shift_south, ~0ULL) |
+                     ray_fill_left(rooks[color], empty, ray_shift_east, not_a_file) |
+                     ray_fill_right(rooks[color], empty, ray_shift_south, ~0ULL) |
+                     ray_fill_right(rooks[color], empty, ray_shift_east, not_h_file) |
+                     ray_fill_left(bishops[color], empty, ray_shift_south_east, not_a_file) |
+                     ray_fill_left(bishops[color], empty, ray_shift_south_west, not_h_file) |
+                     ray_fill_right(bishops[color], empty, ray_shift_south_east, not_h_file) |
+                     ray_fill_right(bishops[color], empty, ray_shift_south_west, not_a_file);
+  }
+}
+
+#endif
+
+// squares attacked by a set of knights
+static inline u64 knight_attack_map(u64 knights)
+{
+  return ((knights >> 17) & not_h_file) | ((knights >> 15) & not_a_file) |
+         ((knights >> 10) & not_hg_file) | ((knights >> 6) & not_ab_file) |
+         ((knights << 17) & not_a_file) | ((knights << 15) & not_h_file) |
+         ((knights << 10) & not_ab_file) | ((knights << 6) & not_hg_file);
+}
+
+// squares attacked by a set of pawns of the given side
+static inline u64 pawn_attack_map(u64 pawns, int side)
+{
+  if (side == white)
+    return ((pawns >> 7) & not_a_file) | ((pawns >> 9) & not_h_file);
+  else
+    return ((pawns << 7) & not_h_file) | ((pawns << 9) & not_a_file);
+}
+
+// squares one step ahead of the given pawns (occupied or not)
+static inline u64 pawn_pushes(u64 pawns, int side)
+{
+  return (side == white) ? pawns >> 8 : pawns << 8;
+}
+
+// build the attacked squares bitboards of both sides [side]
+static inline void generate_attack_maps(u64 attacks[2])
+{
+  // straight and diagonal sliders of both sides
+  u64 rooks[2] = {bitboards[R] | bitboards[Q], bitboards[r] | bitboards[q]};
+  u64 bishops[2] = {bitboards[B] | bitboards[Q], bitboards[b] | bitboards[q]};
+
+  slider_attack_maps(rooks, bishops, ~occupancies[both], attacks);
+
+  // add pawns, knights and king
+  for (int color = white; color <= black; color++)
+  {
+    int offset = (color == white) ? 0 : p;
+
+    attacks[color] |= pawn_attack_map(bitboards[P + offset], color) |
+                      knight_attack_map(bitboards[N + offset]);
+
+    if (bitboards[K + offset])
+      attacks[color] |= king_attacks[get_lsb1st_index(bitboards[K + offset])];
+  }
+}
+
+/*
+ *
+ *                Move Generation
+ *
+ */
+
+//  is current given square attacked by the given side (a constant, so the side tests fold away)
+force_inline int is_square_attacked_by(int square, const int by)
+{
+  stats_inc(attack_queries);
+
+  // attacked by white pawns
+  if ((by == white) && (pawn_attacks[black][square] & bitboards[P]))
+    return 1;
+
+  // attacked by black pawns
+  if ((by == black) && (pawn_attacks[white][square] & bitboards[p]))
+    return 1;
+
+  // attacked by knights
+  if (knight_attacks[square] & ((by == white) ? bitboards[N] : bitboards[n]))
+    return 1;
+
+  // attacked by bishops
+  if (get_bishop_attacks(square, occupancies[both]) & ((by == white) ? bitboards[B] : bitboards[b]))
+    return 1;
+
+  // attacked by rooks
+  if (get_rook_attacks(square, occupancies[both]) & ((by == white) ? bitboards[R] : bitboards[r]))
+    return 1;
+
+  // attacked by queens
+  if (get_queen_attacks(square, occupancies[both]) & ((by == white) ? bitboards[Q] : bitboards[q]))
+    return 1;
+
+  // attacked by kings
+  if (king_attacks[square] & ((by == white) ? bitboards[K] : bitboards[k]))
+    return 1;
+
+  return 0;
+}
+
+//  is current given square attacked by the current givrn side
+static inline int is_square_attacked(int square, int side)
+{
+  return (side == white) ? is_square_attacked_by(square, white) : is_square_attacked_by(square, black);
+}
+
+// pieces of the given side attacking the given square
+static inline u64 attackers_to(int square, int side)
+{
+  int offset = (side == white) ? 0 : p;
+
+  return (pawn_attacks[side ^ 1][square] & bitboards[P + offset]) |
+         (knight_attacks[square] & bitboards[N + offset]) |
+         (get_bishop_attacks(square, occupancies[both]) & (bitboards[B + offset] | bitboards[Q + offset])) |
+         (get_rook_attacks(square, occupancies[both]) & (bitboards[R + offset] | bitboards[Q + offset])) |
+         (king_attacks[square] & bitboards[K + offset]);
+}
+
+// squares strictly between two squares on a common rank, file or diagonal (empty otherwise)
+static inline u64 between_squares(int from, int to)
+{
+  // the rays of both squares blocked by each other overlap in between only
+  if (get_rook_attacks(from, 0ULL) & (1ULL << to))
+    return get_rook_attacks(from, 1ULL << to) & get_rook_attacks(to, 1ULL << from);
+
+  if (get_bishop_attacks(from, 0ULL) & (1ULL << to))
+    return get_bishop_attacks(from, 1ULL << to) & get_bishop_attacks(to, 1ULL << from);
+
+  return 0ULL;
+}
+
+#ifdef STATS_RDTSC
+// sample the cycles of all the calls from here on
+#define is_square_attacked(square, side) stats_sample(timer_is_square_attacked, is_square_attacked(square, side))
+#define is_square_attacked_by(square, by) stats_sample(timer_is_square_attacked, is_square_attacked_by(square, by))
+#endif
+
+void print_attacked_squares(int side)
+{
+  // attacked squares of both sides
+  u64 attacks[2];
+  generate_attack_maps(attacks);
+
+  printf("\n");
+  for (int rank = 0; rank < 8; rank++)
+  {
+    for (int file = 0; file < 8; file++)
+    {
+      int square = rank * 8 + file;
+      if (!file)
+        printf("  %d  ", 8 - rank);
+
+      printf("%d ", get_bit(attacks[side], square) ? 1 : 0);
+    }
+    printf("\n");
+  }
+
+  printf("\n     A B C D E F G H \n\n");
+}
+
+/*
+ *    Binary Move Bits                                            hexadecimal constants
+ *
+ *    0000 0000 0000 0000 0011 1111    source square              0x3f
+ *    0000 0000 0000 1111 1100 0000    target square              0xfc0
+ *    0000 0000 1111 0000 0000 0000    piece                      0xf000
+ *    0000 1111 0000 0000 0000 0000    promoted piece             0xf0000
+ *    0001 0000 0000 0000 0000 0000    capture flag               0x100000
+ *    0010 0000 0000 0000 0000 0000    double push flag           0x200000
+ *    0100 0000 0000 0000 0000 0000    enpassant flag             0x400000
+ *    1000 0000 0000 0000 0000 0000    castling flag              0x800000
+ */
+
+// encode move
+#define encode_move(source, target, piece, promoted, capture, double, enpassant, castling) \
+  (source) | (target << 6) | (piece << 12) | (promoted << 16) | (capture << 20) | (double << 21) | (enpassant << 22) | (castling << 23)
+
+// extract source square
+#define get_move_source(move) (move & 0x3f)
+
+// extract target square
+#define get_move_target(move) ((move & 0xfc0) >> 6)
+
+// extract piece
+#define get_move_piece(move) ((move & 0xf000) >> 12)
+
+// extract promoted piece
+#define get_move_promoted(move) ((move & 0xf0000) >> 16)
+
+// extract capture flag
+#define get_move_capture(move) ((move & 0x100000))
+
+// extract double push flag
+#define get_move_double(move) ((move & 0x200000))
+
+// extract enpassant flag
+#define get_move_enpassant(move) ((move & 0x400000))
+
+// extract castling flag
+#define get_move_castle(move) ((move & 0x800000))
+
+// move list structutre
+typedef struct
+{
+  // moves
+  int moves[256];
+
+  // move count
+  int count;
+
+} moves;
+
+static inline void add_move(moves *move_list, int move)
+{
+  stats_inc(moves_generated[get_move_piece(move)]);
+
+  // store move
+  move_list->moves[move_list->count] = move;
+
+  // increment move count
+  move_list->count++;
+}
+
+/*
+ *    Compact Move Bits (TT entries, PV, killers)                hexadecimal constants
+ *
+ *    0000 0000 0011 1111    source square                       0x3f
+ *    0000 1111 1100 0000    target square                       0xfc0
+ *    0011 0000 0000 0000    promotion type (N, B, R, Q)         0x3000
+ *    1100 0000 0000 0000    special (promotion, enpassant,      0xc000
+ *                           castling)
+ *
+ *    Moving piece, capture and double push flags are not stored,
+ *    they are read back from the board the move is played on
+ */
+
+// compact move special types
+enum
+{
+  special_none,
+  special_promotion,
+  special_enpassant,
+  special_castling
+};
+
+// extract compact source square
+#define get_packed_source(packed) ((packed) & 0x3f)
+
+// extract compact target square
+#define get_packed_target(packed) (((packed) >> 6) & 0x3f)
+
+// extract compact promotion type (0 = knight ... 3 = queen)
+#define get_packed_promotion(packed) (((packed) >> 12) & 0x3)
+
+// extract compact special type
+#define get_packed_special(packed) (((packed) >> 14) & 0x3)
+
+// pack full move into 16 bits
+static inline int pack_move(int move)
+{
+  // source and target squares
+  int packed = get_move_source(move) | (get_move_target(move) << 6);
+
+  // promotion type relative to knight (same for both colours)
+  if (get_move_promoted(move))
+    packed |= ((get_move_promoted(move) % 6 - N) << 12) | (special_promotion << 14);
+
+  // enpassant capture
+  else if (get_move_enpassant(move))
+    packed |= special_enpassant << 14;
+
+  // castling move
+  else if (get_move_castle(move))
+    packed |= special_castling << 14;
+
+  return packed;
+}
+
+// unpack compact move against the current board (0 if no piece of side to move on source)
+static inline int unpack_move(int packed)
+{
+  int source_square = get_packed_source(packed);
+  int target_square = get_packed_target(packed);
+  int special = get_packed_special(packed);
+
+  // pick up bitboard piece index range of side to move
+  int start_piece = (side == white) ? P : p;
+  int piece = -1;
+
+  // find moving piece on source square
+  for (int bb_piece = start_piece; bb_piece <= start_piece + K; bb_piece++)
+  {
+    if (get_bit(bitboards[bb_piece], source_square))
+    {
+      piece = bb_piece;
+      break;
+    }
+  }
+
+  // no piece to move
+  if (piece == -1)
+    return 0;
+
+  // capture flag from the board
+  int capture = (get_bit(occupancies[side ^ 1], target_square) || special == special_enpassant) ? 1 : 0;
+
+  // double pawn push
+  int double_push = ((piece == P || piece == p) && abs(target_square - source_square) == 16) ? 1 : 0;
+
+  // promoted piece of side to move
+  int promoted = (special == special_promotion) ? start_piece + N + get_packed_promotion(packed) : 0;
+
+  return encode_move(source_square, target_square, piece, promoted, capture, double_push,
+                     special == special_enpassant, special == special_castling);
+}
+
+// print move (for UCI purpose)
+void print_move(int move)
+{
+  printf("%s %s %c\n", square_to_coordinates[get_move_source(move)], square_to_coordinates[get_move_target(move)], promoted_pieces[get_move_promoted(move)]);
+}
+
+// print move (for debuging functions)
+void print_move_list(moves *move_list)
+
+{
+  if (!move_list->count)
+  {
+    printf("\n       No Moves in the move list\n\n");
+    return;
+  }
+  printf("\n       move   piece   capture   double   enpassant   castling\n\n");
+  for (int move_count = 0; move_count < move_list->count; move_count++)
+  {
+    // init move
+    int move = move_list->moves[move_count];
+#ifdef WIN64
+    printf("     %s%s%c   %c         %d        %d          %d          %d\n", square_to_coordinates[get_move_source(move)], square_to_coordinates[get_move_target(move)], promoted_pieces[get_move_promoted(move)] ? promoted_pieces[get_move_promoted(move)] : ' ', ascii_pieces[get_move_piece(move)], get_move_capture(move) ? 1 : 0, get_move_double(move) ? 1 : 0, get_move_enpassant(move) ? 1 : 0, get_move_castle(move) ? 1 : 0);
+#else
+    printf("     %s%s%c   %s         %d        %d          %d          %d\n", square_to_coordinates[get_move_source(move)], square_to_coordinates[get_move_target(move)], (promoted_pieces[get_move_promoted(move)] ? promoted_pieces[get_move_promoted(move)] : ' '), unicode_pieces[get_move_piece(move)], get_move_capture(move) ? 1 : 0, get_move_double(move) ? 1 : 0, get_move_enpassant(move) ? 1 : 0, get_move_castle(move) ? 1 : 0);
+#endif
+
+    // total number of moves
+  }
+  printf("\n\n     Total number of moves: %d\n", move_list->count);
+}
+
+// board state saved before making a move
+typedef struct
+{
+  u64 bitboards[12];
+  u64 occupancies[3];
+  int side, enpassant, castle, fifty;
+  u64 hash_key, pawn_key;
+} undo_state;
+
+// preserve board state in the undo record of the current ply (see search_stack)
+#define copy_board()                                                \
+  undo_state *undo = &search_stack[ply].undo;                       \
+  memcpy(undo->bitboards, bitboards, 96);                           \
+  memcpy(undo->occupancies, occupancies, 24);                       \
+  undo->side = side, undo->enpassant = enpassant, undo->castle = castle; \
+  undo->fifty = fifty;                                              \
+  undo->hash_key = hash_key, undo->pawn_key = pawn_key;
+
+// restore board state preserved by copy_board() in the same scope
+#define take_back()                                                 \
+  memcpy(bitboards, undo->bitboards, 96);                           \
+  memcpy(occupancies, undo->occupancies, 24);                       \
+  side = undo->side, enpassant = undo->enpassant, castle = undo->castle; \
+  fifty = undo->fifty;                                              \
+  hash_key = undo->hash_key, pawn_key = undo->pawn_key;
+
+enum
+{
+  all_moves,
+  only_captures
+};
+
+/*
+ * king & rooks didnt move :   1111 & 1111 = 1111  15
+ *
+ * white king moved        :   1111 & 1100 = 1100  12
+ * white kings rook moved  :   1111 & 1110 = 1110  14
+ * white queen rook moved  :   1111 & 1101 = 1101  13
+ *
+ * black king moved        :   1111 & 0011 = 1100  03
+ * black kings rook moved  :   1111 & 1011 = 1011  11
+ * black queen rook moved  :   1111 & 0111 = 0111  07
+ */
+
+// castling rights upadte constants
+const int castling_rights[64] = {
+    07, 15, 15, 15, 03, 15, 15, 11,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    13, 15, 15, 15, 12, 15, 15, 14};
+
+// make move on chess board (returns 0 and leaves the board as it is when the move is illegal,
+// so the caller restores it from its copy_board() record)
+// make a move of the given side (a constant, so the side tests fold away)
+force_inline int make_move_side(int move, const int us)
+{
+  stats_inc(moves_made);
+
+  // parse move
+  int source_square = get_move_source(move);
+  int target_square = get_move_target(move);
+  int piece = get_move_piece(move);
+  int promoted_piece = get_move_promoted(move);
+  int capture = get_move_capture(move);
+  int double_push = get_move_double(move);
+  int enpass = get_move_enpassant(move);
+  int castling = get_move_castle(move);
+
+  // move piece
+  pop_bit(bitboards[piece], source_square);
+  set_bit(bitboards[piece], target_square);
+  pop_bit(occupancies[us], source_square);
+  set_bit(occupancies[us], target_square);
+
+  // hash piece (remove piece from source square and put it on target square)
+  hash_key ^= piece_keys[piece][source_square];
+  hash_key ^= piece_keys[piece][target_square];
+
+  // increment fifty move rule counter (reset on pawn moves)
+  fifty++;
+  if (piece == ((us == white) ? P : p))
+  {
+    fifty = 0;
+
+    // hash pawn move into the pawn structure key
+    pawn_key ^= piece_keys[piece][source_square] ^ piece_keys[piece][target_square];
+  }
+
+  // handling capture moves
+  if (capture)
+  {
+    // reset fifty move rule counter
+    fifty = 0;
+
+    // loop over the enemy pieces
+    for (int bb_piece = (us == white) ? p : P; bb_piece <= ((us == white) ? k : K); bb_piece++)
+    {
+
+      if (get_bit(bitboards[bb_piece], target_square))
+      {
+        pop_bit(bitboards[bb_piece], target_square);
+        pop_bit(occupancies[us ^ 1], target_square);
+
+        // remove the captured piece from hash key
+        hash_key ^= piece_keys[bb_piece][target_square];
+
+        // captured pawn leaves the pawn structure
+        if (bb_piece == ((us == white) ? p : P))
+          pawn_key ^= piece_keys[bb_piece][target_square];
+        break;
+      }
+    }
+  }
+
+  // handle pawn promotions
+  if (promoted_piece)
+  {
+    // erase the pawn from target square (and from hash key)
+    pop_bit(bitboards[(us == white) ? P : p], target_square);
+    hash_key ^= piece_keys[(us == white) ? P : p][target_square];
+    pawn_key ^= piece_keys[(us == white) ? P : p][target_square];
+
+    // set up promoted piece on chess board (and hash it)
+    set_bit(bitboards[promoted_piece], target_square);
+    hash_key ^= piece_keys[promoted_piece][target_square];
+  }
+
+  // handle enpassant capture
+  if (enpass)
+  {
+    // erase the pawn depending on side to move
+    if (us == white)
+    {
+      pop_bit(bitboards[p], target_square + 8);
+      pop_bit(occupancies[black], target_square + 8);
+      hash_key ^= piece_keys[p][target_square + 8];
+      pawn_key ^= piece_keys[p][target_square + 8];
+    }
+    else
+    {
+      pop_bit(bitboards[P], target_square - 8);
+      pop_bit(occupancies[white], target_square - 8);
+      hash_key ^= piece_keys[P][target_square - 8];
+      pawn_key ^= piece_keys[P][target_square - 8];
+    }
+  }
+
+  // remove enpassant square from hash key
+  if (enpassant != no_sq)
+  {
+    hash_key ^= enpassant_keys[enpassant];
+  }
+
+  // reset enpassant square
+  enpassant = no_sq;
+
+  if (double_push)
+  {
+    (us == white) ? (enpassant = target_square + 8) : (enpassant = target_square - 8);
+
+    // hash enpassant square
+    hash_key ^= enpassant_keys[enpassant];
+  }
+
+  if (castling)
+  {
+    switch (target_square)
+    {
+    // white castles king side
+    case (g1):
+      // move H rook
+      pop_bit(bitboards[R], h1);
+      set_bit(bitboards[R], f1);
+      pop_bit(occupancies[white], h1);
+      set_bit(occupancies[white], f1);
+      hash_key ^= piece_keys[R][h1] ^ piece_keys[R][f1];
+      break;
+      // white castles queen side
+    case (c1):
+      pop_bit(bitboards[R], a1);
+      set_bit(bitboards[R], d1);
+      pop_bit(occupancies[white], a1);
+      set_bit(occupancies[white], d1);
+      hash_key ^= piece_keys[R][a1] ^ piece_keys[R][d1];
+      break;
+      // black castles king side
+    case (g8):
+      pop_bit(bitboards[r], h8);
+      set_bit(bitboards[r], f8);
+      pop_bit(occupancies[black], h8);
+      set_bit(occupancies[black], f8);
+      hash_key ^= piece_keys[r][h8] ^ piece_keys[r][f8];
+      break;
+      // black castles queen side
+    case (c8):
+      pop_bit(bitboards[r], a8);
+      set_bit(bitboards[r], d8);
+      pop_bit(occupancies[black], a8);
+      set_bit(occupancies[black], d8);
+      hash_key ^= piece_keys[r][a8] ^ piece_keys[r][d8];
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  // update castling rights (and hash them)
+  hash_key ^= castle_keys[castle];
+  castle &= castling_rights[source_square];
+  castle &= castling_rights[target_square];
+  hash_key ^= castle_keys[castle];
+
+  // update both side occupancies (the side ones were updated along with the pieces)
+  occupancies[both] = occupancies[white] | occupancies[black];
+
+  // change side
+  side ^= 1;
+  hash_key ^= side_key;
+
+  // make sure that the king is not exposed
+  if (is_square_attacked_by(get_lsb1st_index(bitboards[(us == white) ? K : k]), us ^ 1))
+  {
+    stats_inc(moves_rejected);
+
+    return 0;
+  }
+  else
+  {
+    return 1;
+  }
+}
+
+static inline int make_move(int move, int move_flag)
+{
+  // capture moves only: reject the quiet ones
+  if (move_flag == only_captures && !get_move_capture(move))
+    return 0;
+
+  // one specialized copy per side to move
+  return (side == white) ? make_move_side(move, white) : make_move_side(move, black);
+}
+
+#ifdef STATS_RDTSC
+#define make_move(move, move_flag) stats_sample(timer_make_move, make_move(move, move_flag))
+#endif
+
+// add the four promotions of a pawn move of the given side
+force_inline void add_promotions(moves *move_list, int source_square, int target_square, int capture, const int us)
+{
+  // white or black pieces
+  int offset = (us == white) ? 0 : p;
+
+  add_move(move_list, encode_move(source_square, target_square, (P + offset), (Q + offset), capture, 0, 0, 0));
+  add_move(move_list, encode_move(source_square, target_square, (P + offset), (R + offset), capture, 0, 0, 0));
+  add_move(move_list, encode_move(source_square, target_square, (P + offset), (B + offset), capture, 0, 0, 0));
+  add_move(move_list, encode_move(source_square, target_square, (P + offset), (N + offset), capture, 0, 0, 0));
+}
+
+// move generator types
+enum
+{
+  all_types,
+  captures_only,
+  quiets_only,
+  check_evasions
+};
+
+// generate the moves of the given side (a constant, so the side tests fold away)
+force_inline void generate_moves_side(moves *move_list, int move_type, const int us)
+{
+  // init move count
+  move_list->count = 0;
+
+  int source_square, target_square;
+
+  // bitboards copy and attack
+  u64 bitboard, attacks;
+
+  // own and enemy pieces
+  u64 own = occupancies[us], enemy = occupancies[us ^ 1];
+
+  // target squares of the king and of the other pieces
+  u64 king_targets, targets;
+
+  if (move_type == captures_only)
+    king_targets = enemy;
+  else if (move_type == quiets_only)
+    king_targets = ~occupancies[both];
+  else
+    king_targets = ~own;
+
+  targets = king_targets;
+
+  // in check the other pieces can only capture the checker or block its ray
+  if (move_type == check_evasions)
+  {
+    u64 checkers = attackers_to(get_lsb1st_index(bitboards[(us == white) ? K : k]), us ^ 1);
+
+    // a double check leaves king moves only
+    targets = (checkers & (checkers - 1)) ? 0 : checkers | between_squares(get_lsb1st_index(bitboards[(us == white) ? K : k]), get_lsb1st_index(checkers));
+  }
+
+  // loop over the pieces of the side to move only
+  for (int piece = (us == white) ? P : p; piece <= ((us == white) ? K : k); piece++)
+  {
+    bitboard = bitboards[piece];
+
+    // generate pawn moves set-wise, for all the pawns at once
+    if (piece == ((us == white) ? P : p))
+    {
+      // promotion and double push ranks
+      const u64 rank_8 = 0xffULL, rank_6 = 0xffULL << 16, rank_3 = 0xffULL << 40, rank_1 = 0xffULL << 56;
+
+      // the last rank and the rank a pawn may push on from
+      u64 last_rank = (us == white) ? rank_8 : rank_1;
+      u64 double_rank = (us == white) ? rank_3 : rank_6;
+
+      // single pushes (the double ones push on from the third rank)
+      u64 single = pawn_pushes(bitboard, us) & ~occupancies[both];
+      u64 double_push = pawn_pushes(single & double_rank, us) & ~occupancies[both];
+
+      // captures towards the A and the H file
+      u64 west = ((us == white) ? (bitboard >> 9) & not_h_file : (bitboard << 7) & not_h_file) & enemy & targets;
+      u64 east = ((us == white) ? (bitboard >> 7) & not_a_file : (bitboard << 9) & not_a_file) & enemy & targets;
+
+      // target = source + step
+      const int step = (us == white) ? -8 : 8;
+
+      // quiet pawn moves (promotions included), not wanted by the captures generator
+      if (move_type != captures_only)
+      {
+        // single pushes
+        attacks = single & targets & ~last_rank;
+        while (attacks)
+        {
+          target_square = get_lsb1st_index(attacks);
+          add_move(move_list, encode_move(target_square - step, target_square, piece, 0, 0, 0, 0, 0));
+
+          pop_bit(attacks, target_square);
+        }
+
+        // double pushes
+        attacks = double_push & targets;
+        while (attacks)
+        {
+          target_square = get_lsb1st_index(attacks);
+          add_move(move_list, encode_move(target_square - 2 * step, target_square, piece, 0, 0, 1, 0, 0));
+
+          pop_bit(attacks, target_square);
+        }
+
+        // promotions
+        attacks = single & targets & last_rank;
+        while (attacks)
+        {
+          target_square = get_lsb1st_index(attacks);
+          add_promotions(move_list, target_square - step, target_square, 0, us);
+
+          pop_bit(attacks, target_square);
+        }
+      }
+
+      // captures towards the A file (promotions on the last rank)
+      attacks = west;
+      while (attacks)
+      {
+        target_square = get_lsb1st_index(attacks);
+
+        if (get_bit(last_rank, target_square))
+          add_promotions(move_list, target_square - step + 1, target_square, 1, us);
+        else
+          add_move(move_list, encode_move(target_square - step + 1, target_square, piece, 0, 1, 0, 0, 0));
+
+        pop_bit(attacks, target_square);
+      }
+
+      // captures towards the H file (promotions on the last rank)
+      attacks = east;
+      while (attacks)
+      {
+        target_square = get_lsb1st_index(attacks);
+
+        if (get_bit(last_rank, target_square))
+          add_promotions(move_list, target_square - step - 1, target_square, 1, us);
+        else
+          add_move(move_list, encode_move(target_square - step - 1, target_square, piece, 0, 1, 0, 0, 0));
+
+        pop_bit(attacks, target_square);
+      }
+
+      //  generate enpassant captures (on evasions as well, the captured pawn may be the checker)
+      if (enpassant != no_sq && move_type != quiets_only)
+      {
+        // pawns attacking the enpassant square
+        attacks = pawn_attacks[us ^ 1][enpassant] & bitboard;
+        while (attacks)
+        {
+          source_square = get_lsb1st_index(attacks);
+          add_move(move_list, encode_move(source_square, enpassant, piece, 0, 1, 0, 1, 0));
+
+          pop_bit(attacks, source_square);
+        }
+      }
+    }
+
+    // generate white king castling moves
+    if (us == white)
+    {
+      // white castling moves
+      if (piece == K)
+      {
+        // king side catling is availiable
+        if ((castle & wk) && (move_type == all_types || move_type == quiets_only))
+        {
+          // make sure square between king and the king side rook are empty
+          if (!get_bit(occupancies[both], f1) && !get_bit(occupancies[both], g1))
+          {
+            // make sure king and f1 square are not attacked by enemy pieces
+            if (!is_castling_square_attacked(e1, black) && !is_castling_square_attacked(f1, black))
+            {
+              add_move(move_list, encode_move(e1, g1, piece, 0, 0, 0, 0, 1));
+            }
+          }
+        }
+        // queen side catling is availiable
+        if ((castle & wq) && (move_type == all_types || move_type == quiets_only))
+        {
+          // make sure square between king and the queen side rook are empty
+          if (!get_bit(occupancies[both], d1) && !get_bit(occupancies[both], c1) && !get_bit(occupancies[both], b1))
+          {
+            // make sure king and d1 square are not attacked by enemy pieces
+            if (!is_castling_square_attacked(e1, black) && !is_castling_square_attacked(d1, black))
+            {
+              add_move(move_list, encode_move(e1, c1, piece, 0, 0, 0, 0, 1));
+            }
+          }
+        }
+      }
+    }
+
+    // generate black king castling moves
+    else
+    {
+      // black castling moves
+      if (piece == k)
+      {
+        // king side castling is availiable
+        if ((castle & bk) && (move_type == all_types || move_type == quiets_only))
+        {
+          // make sure square between king and the king side rook are empty
+          if (!get_bit(occupancies[both], f8) && !get_bit(occupancies[both], g8))
+          {
+            // make sure king and f8 square are not attacked by enemy pieces
+            if (!is_castling_square_attacked(e8, white) && !is_castling_square_attacked(f8, white))
+            {
+              add_move(move_list, encode_move(e8, g8, piece, 0, 0, 0, 0, 1));
+            }
+          }
+        }
+
+        // queen side castling is availiable
+        if ((castle & bq) && (move_type == all_types || move_type == quiets_only))
+        {
+          // make sure square between king and the queen side rook are empty
+          if (!get_bit(occupancies[both], d8) && !get_bit(occupancies[both], c8) && !get_bit(occupancies[both], b8))
+          {
+            // make sure king and d8 square are not attacked by enemy pieces
+            if (!is_castling_square_attacked(e8, white) && !is_castling_square_attacked(d8, white))
+            {
+              add_move(move_list, encode_move(e8, c8, piece, 0, 0, 0, 0, 1));
+            }
+          }
+        }
+      }
+    }
+
+    // generate knight moves
+    if ((us == white) ? piece == N : piece == n)
+    {
+      // loop over source squares of piece bitboard copy
+      while (bitboard)
+      {
+        // init source square
+        source_square = get_lsb1st_index(bitboard);
+        // init piece attacks in order to get set of target squares
+        attacks = knight_attacks[source_square] & targets;
+
+        // loop over target squares available from generated attacks
+        while (attacks)
+        {
+          // init target square
+          target_square = get_lsb1st_index(attacks);
+
+          // quite moves
+          if (!get_bit((us == white) ? occupancies[black] : occupancies[white], target_square))
+          {
+            add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
+          }
+          // capture moves
+          else
+          {
+            add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
+          }
+
+          // pop ls1b in attacks
+          pop_bit(attacks, target_square);
+        }
+
+        // pop the bit
+        pop_bit(bitboard, source_square);
+      }
+    }
+
+    // generate bishop moves
+    if ((us == white) ? piece == B : piece == b)
+    {
+      // loop over source squares of piece bitboard copy
+      while (bitboard)
+      {
+        // init source square
+        source_square = get_lsb1st_index(bitboard);
+        // init piece attacks in order to get set of target squares
+        attacks = get_bishop_attacks(source_square, occupancies[both]) & targets;
+
+        // loop over target squares available from generated attacks
+        while (attacks)
+        {
+          // init target square
+          target_square = get_lsb1st_index(attacks);
+
+          // quite moves
+          if (!get_bit((us == white) ? occupancies[black] : occupancies[white], target_square))
+          {
+            add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
+          }
+          // capture moves
+          else
+          {
+            add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
+          }
+
+          // pop ls1b in attacks
+          pop_bit(attacks, target_square);
+        }
+
+        // pop the bit
+        pop_bit(bitboard, source_square);
+      }
+    }
+
+    // generate rook moves
+    if ((us == white) ? piece == R : piece == r)
+    {
+      // loop over source squares of piece bitboard copy
+      while (bitboard)
+      {
+        // init source square
+        source_square = get_lsb1st_index(bitboard);
+        // init piece attacks in order to get set of target squares
+        attacks = get_rook_attacks(source_square, occupancies[both]) & targets;
+
+        // loop over target squares available from generated attacks
+        while (attacks)
+        {
+          // init target square
+          target_square = get_lsb1st_index(attacks);
+
+          // quite moves
+          if (!get_bit((us == white) ? occupancies[black] : occupancies[white], target_square))
+          {
+            add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
+          }
+          // capture moves
+          else
+          {
+            add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
+          }
+
+          // pop ls1b in attacks
+          pop_bit(attacks, target_square);
+        }
+
+        // pop the bit
+        pop_bit(bitboard, source_square);
+      }
+    }
+
+    // generate queen moves
+    if ((us == white) ? piece == Q : piece == q)
+    {
+      // loop over source squares of piece bitboard copy
+      while (bitboard)
+      {
+        // init source square
+        source_square = get_lsb1st_index(bitboard);
+        // init piece attacks in order to get set of target squares
+        attacks = get_queen_attacks(source_square, occupancies[both]) & targets;
+
+        // loop over target squares available from generated attacks
+        while (attacks)
+        {
+          // init target square
+          target_square = get_lsb1st_index(attacks);
+
+          // quite moves
+          if (!get_bit((us == white) ? occupancies[black] : occupancies[white], target_square))
+          {
+            add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
+          }
+          // capture moves
+          else
+          {
+            add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
+          }
+
+          // pop ls1b in attacks
+          pop_bit(attacks, target_square);
+        }
+
+        // pop the bit
+        pop_bit(bitboard, source_square);
+      }
+    }
+
+    // generate king moves
+    if ((us == white) ? piece == K : piece == k)
+    {
+      // loop over source squares of piece bitboard copy
+      while (bitboard)
+      {
+        // init source square
+        source_square = get_lsb1st_index(bitboard);
+        // init piece attacks in order to get set of target squares
+        attacks = king_attacks[source_square] & king_targets;
+
+        // loop over target squares available from generated attacks
+        while (attacks)
+        {
+          // init target square
+          target_square = get_lsb1st_index(attacks);
+
+          // quite moves
+          if (!get_bit((us == white) ? occupancies[black] : occupancies[white], target_square))
+          {
+            add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
+          }
+          // capture moves
+          else
+          {
+            add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
+          }
+
+          // pop ls1b in attacks
+          pop_bit(attacks, target_square);
+        }
+
+        // pop the bit
+        pop_bit(bitboard, source_square);
+      }
+    }
+  }
+}
+
+static inline void generate_moves_by_type(moves *move_list, int move_type)
+{
+  // one specialized copy per side to move
+  if (side == white)
+    generate_moves_side(move_list, move_type, white);
+  else
+    generate_moves_side(move_list, move_type, black);
+}
+
+// generate all pseudo legal moves
+static inline void generate_moves(moves *move_list)
+{
+  generate_moves_by_type(move_list, all_types);
+}
+
+// generate captures, capture promotions and enpassant only
+static inline void generate_captures(moves *move_list)
+{
+  generate_moves_by_type(move_list, captures_only);
+}
+
+// generate quiet moves, quiet promotions and castling only
+static inline void generate_quiets(moves *move_list)
+{
+  generate_moves_by_type(move_list, quiets_only);
+}
+
+// generate check evasions: king moves, captures of the checker and blocks of its ray
+static inline void generate_evasions(moves *move_list)
+{
+  generate_moves_by_type(move_list, check_evasions);
+}
+
+#ifdef STATS_RDTSC
+#define generate_moves(move_list) stats_sample_void(timer_generate_moves, generate_moves(move_list))
+#endif
+
+/*
+ *
+ *                Evaluation
+ *
+ */
+
+// material score [piece]
+const int material_score[12] = {
+    100,    // white pawn score
+    300,    // white knight scrore
+    350,    // white bishop score
+    500,    // white rook score
+    1000,   // white queen score
+    10000,  // white king score
+    -100,   // black pawn score
+    -300,   // black knight scrore
+    -350,   // black bishop score
+    -500,   // black rook score
+    -1000,  // black queen score
+    -10000, // black king score
+};
+
+// pawn positional score
+const int pawn_score[64] = {
+    90, 90, 90, 90, 90, 90, 90, 90,
+    30, 30, 30, 40, 40, 30, 30, 30,
+    20, 20, 20, 30, 30, 30, 20, 20,
+    10, 10, 10, 20, 20, 10, 10, 10,
+    5, 5, 10, 20, 20, 5, 5, 5,
+    0, 0, 0, 5, 5, 0, 0, 0,
+    0, 0, 0, -10, -10, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0};
+
+// knight positional score
+const int knight_score[64] = {
+    -5, 0, 0, 0, 0, 0, 0, -5,
+    -5, 0, 0, 10, 10, 0, 0, -5,
+    -5, 5, 20, 20, 20, 20, 5, -5,
+    -5, 10, 20, 30, 30, 20, 10, -5,
+    -5, 10, 20, 30, 30, 20, 10, -5,
+    -5, 5, 20, 10, 10, 20, 5, -5,
+    -5, 0, 0, 0, 0, 0, 0, -5,
+    -5, -10, 0, 0, 0, 0, -10, -5};
+
+// bishop positional score
+const int bishop_score[64] = {
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 10, 10, 0, 0, 0,
+    0, 0, 10, 20, 20, 10, 0, 0,
+    0, 0, 10, 20, 20, 10, 0, 0,
+    0, 10, 0, 0, 0, 0, 10, 0,
+    0, 30, 0, 0, 0, 0, 30, 0,
+    0, 0, -10, 0, 0, -10, 0, 0};
+
+// rook positional score
+const int rook_score[64] = {
+    50, 50, 50, 50, 50, 50, 50, 50,
+    50, 50, 50, 50, 50, 50, 50, 50,
+    0, 0, 10, 20, 20, 10, 0, 0,
+    0, 0, 10, 20, 20, 10, 0, 0,
+    0, 0, 10, 20, 20, 10, 0, 0,
+    0, 0, 10, 20, 20, 10, 0, 0,
+    0, 0, 10, 20, 20, 10, 0, 0,
+    0, 0, 0, 20, 20, 0, 0, 0};
+
+// king positional score
+const int king_score[64] = {
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 5, 5, 5, 5, 0, 0,
+    0, 5, 5, 10, 10, 5, 5, 0,
+    0, 5, 10, 20, 20, 10, 5, 0,
+    0, 5, 10, 20, 20, 10, 5, 0,
+    0, 0, 5, 10, 10, 5, 0, 0,
+    0, 5, 5, -5, -5, 0, 5, 0,
+    0, 0, 5, 0, -15, 0, 10, 0};
+
+// mirror square vertically (positional scores are given from white's point of view)
+#define mirror_square(square) ((square) ^ 56)
+
+// bonus per attacked square not occupied by own pieces
+const int mobility_bonus = 1;
+
+// penalty per square next to the king attacked by the opponent
+const int king_zone_penalty = 5;
+
+// position evaluation (relative to the side to move)
+static inline int evaluate()
+{
+  // static evaluation score
+  int score = 0;
+
+  // current pieces bitboard copy
+  u64 bitboard;
+
+  // init piece & square
+  int piece, square;
+
+  // loop over piece bitboards
+  for (int bb_piece = P; bb_piece <= k; bb_piece++)
+  {
+    // init piece bitboard copy
+    bitboard = bitboards[bb_piece];
+
+    // loop over pieces within a bitboard
+    while (bitboard)
+    {
+      // init piece
+      piece = bb_piece;
+
+      // init square
+      square = get_lsb1st_index(bitboard);
+
+      // score material weights
+      score += material_score[piece];
+
+      // score positional piece scores
+      switch (piece)
+      {
+      // evaluate white pieces
+      case P:
+        score += pawn_score[square];
+        break;
+      case N:
+        score += knight_score[square];
+        break;
+      case B:
+        score += bishop_score[square];
+        break;
+      case R:
+        score += rook_score[square];
+        break;
+      case K:
+        score += king_score[square];
+        break;
+
+      // evaluate black pieces
+      case p:
+        score -= pawn_score[mirror_square(square)];
+        break;
+      case n:
+        score -= knight_score[mirror_square(square)];
+        break;
+      case b:
+        score -= bishop_score[mirror_square(square)];
+        break;
+      case r:
+        score -= rook_score[mirror_square(square)];
+        break;
+      case k:
+        score -= king_score[mirror_square(square)];
+        break;
+      }
+
+      // pop ls1b
+      pop_bit(bitboard, square);
+    }
+  }
+
+  // attacked squares of both sides
+  u64 attacks[2];
+  generate_attack_maps(attacks);
+
+  // score mobility
+  score += (count_bits(attacks[white] & ~occupancies[white]) - count_bits(attacks[black] & ~occupancies[black])) * mobility_bonus;
+
+  // score king safety
+  if (bitboards[K])
+    score -= count_bits(attacks[black] & king_attacks[get_lsb1st_index(bitboards[K])]) * king_zone_penalty;
+
+  if (bitboards[k])
+    score += count_bits(attacks[white] & king_attacks[get_lsb1st_index(bitboards[k])]) * king_zone_penalty;
+
+  // return final evaluation based on side
+  return (side == white) ? score : -score;
+}
+
+/*
+ *
+ *            Evaluation Cache
+ *
+ *  Iterative deepening and quiescence search keep evaluating the same
+ *  positions. Every thread keeps a small direct mapped cache of static
+ *  scores: the low bits of the hash key pick the slot, the entry stores the
+ *  remaining key bits above the 16 bit score. The cache is allocated on the
+ *  first evaluation of a thread and sized by "setoption name EvalCache".
+ *
+ */
+
+// default eval cache size per thread in MB (0 disables the cache)
+#define default_eval_cache_size 1
+
+// eval cache size per thread in MB of threads started from now on (per session, handed to its search threads)
+__thread int eval_cache_size = default_eval_cache_size;
+
+// eval cache of the current thread (key bits above 16 | score)
+__thread u64 *eval_cache;
+__thread u64 eval_cache_entries;
+
+// size the cache of the current thread was allocated with (-1 not yet)
+__thread int eval_cache_mb = -1;
+
+// probes of the current thread
+__thread long eval_cache_hits, eval_cache_misses;
+
+// (re)allocate the eval cache of the current thread
+void init_eval_cache()
+{
+  free(eval_cache);
+  eval_cache = NULL;
+  eval_cache_entries = 0;
+  eval_cache_mb = eval_cache_size;
+
+  // cache disabled
+  if (eval_cache_mb == 0)
+    return;
+
+  // largest power of two number of entries within the size
+  eval_cache_entries = 1;
+  while (eval_cache_entries * 2 * sizeof(u64) <= (u64)eval_cache_mb * 0x100000)
+    eval_cache_entries *= 2;
+
+  eval_cache = calloc(eval_cache_entries, sizeof(u64));
+
+  // run without cache if allocation fails
+  if (eval_cache == NULL)
+    eval_cache_entries = 0;
+}
+
+// forget the cached scores of the current thread
+void clear_eval_cache()
+{
+  if (eval_cache != NULL)
+    memset(eval_cache, 0, eval_cache_entries * sizeof(u64));
+}
+
+// release the eval cache of the current thread (before the thread exits)
+void free_eval_cache()
+{
+  free(eval_cache);
+  eval_cache = NULL;
+  eval_cache_entries = 0;
+  eval_cache_mb = -1;
+}
+
+// static evaluation through the eval cache of the current thread
+static inline int cached_evaluate()
+{
+  // first evaluation of this thread
+  if (eval_cache_mb < 0)
+    init_eval_cache();
+
+  if (eval_cache_entries == 0)
+    return evaluate();
+
+  u64 *entry = &eval_cache[hash_key & (eval_cache_entries - 1)];
+
+  // same key bits: return the cached score
+  if (((*entry ^ hash_key) & ~0xffffULL) == 0)
+  {
+    eval_cache_hits++;
+    return (short)(*entry & 0xffff);
+  }
+
+  eval_cache_misses++;
+
+  int score = evaluate();
+
+  *entry = (hash_key & ~0xffffULL) | (unsigned short)score;
+
+  return score;
+}
+
+/*
+ *
+ *            Transposition Table
+ *
+ */
+
+// default hash table size in MB
+#define default_hash_size 64
+
+// no hash entry found constant
+#define no_hash_entry 100000
+
+// transposition table hash flags
+#define hash_flag_exact 0
+#define hash_flag_alpha 1
+#define hash_flag_beta 2
+
+/*
+ *    Hash entry data bits
+ *
+ *    0000 0000 0000 0000 0000 0000 0000 0000 1111 1111 1111 1111    compact best move  0xffff
+ *    0000 0000 0000 0000 0000 0000 0000 0011 0000 0000 0000 0000    hash flag          0x30000
+ *    0000 0000 0000 0000 0000 0000 1111 1100 0000 0000 0000 0000    depth              0xfc0000
+ *    (upper 32 bits)                                                 score
+ *
+ *    The entry key is stored xor'ed with the data, so an entry torn by
+ *    two threads writing at once simply fails the key check on probe
+ */
+
+// pack hash entry data
+#define encode_hash_data(move, flag, depth, score) \
+  ((u64)(move) | ((u64)(flag) << 16) | ((u64)(depth) << 18) | ((u64)(unsigned int)(score) << 32))
+
+// extract best move (compact)
+#define get_hash_move(data) ((int)((data) & 0xffff))
+
+// extract hash flag
+#define get_hash_flag(data) ((int)(((data) >> 16) & 0x3))
+
+// extract depth
+#define get_hash_depth(data) ((int)(((data) >> 18) & 0x3f))
+
+// extract score
+#define get_hash_score(data) ((int)((data) >> 32))
+
+// transposition table entry
+typedef struct
+{
+  u64 key;  // "almost" unique chess position identifier xor'ed with data
+  u64 data; // packed best move, hash flag, depth and score
+} tt;
+
+// hash table shared by all search threads
+tt *hash_table = NULL;
+
+// number of hash table entries
+u64 hash_entries = 0;
+
+// number of threads clearing the hash table (one per CPU)
+int hash_clear_threads = 1;
+
+// max number of threads clearing the hash table
+#define max_clear_threads 64
+
+// clear a slice of the hash table [thread index]
+void *clear_hash_slice(void *argument)
+{
+  // init slice bounds
+  long index = (long)argument;
+  long threads = hash_clear_threads;
+
+  u64 first = hash_entries * index / threads;
+  u64 last = hash_entries * (index + 1) / threads;
+
+  // the first write maps the pages on the NUMA node this thread runs on
+  memset(hash_table + first, 0, (last - first) * sizeof(tt));
+
+  return NULL;
+}
+
+// clear the hash table (in parallel, so that its pages get spread over all NUMA nodes)
+void clear_hash_table()
+{
+  pthread_t threads[max_clear_threads];
+
+  // clear the slices on all but the first thread
+  int started = 1;
+
+  while (started < hash_clear_threads && pthread_create(&threads[started], NULL, clear_hash_slice, (void *)(long)started) == 0)
+    started++;
+
+  // clear the first slice on this thread and any slices left over by failed thread starts
+  for (long index = 0; index < hash_clear_threads; index++)
+    if (index == 0 || index >= started)
+      clear_hash_slice((void *)index);
+
+  // wait for the other slices
+  for (int index = 1; index < started; index++)
+    pthread_join(threads[index], NULL);
+}
+
+/*
+    Hash file layout (entries stored exactly as in memory):
+
+        tt_file_header
+        tt entries [header.entries]
+
+    A file is only accepted if it was written with the same hash keys
+    (Zobrist seed and side key) and the same entry format version.
+*/
+
+// hash file entry format version (bump when the entry packing changes)
+#define tt_file_version 2
+
+// hash file header
+typedef struct
+{
+  char magic[8];         // "ESABTT" file signature
+  unsigned int version;  // entry format version
+  unsigned int seed;     // Zobrist random state seed
+  u64 side_key;          // last generated Zobrist key, catches key generation changes
+  u64 entries;           // number of entries following the header
+} tt_file_header;
+
+// hash file signature
+const char tt_file_magic[8] = "ESABTT";
+
+// init header describing the current hash table
+void init_hash_file_header(tt_file_header *header)
+{
+  memset(header, 0, sizeof(tt_file_header));
+  memcpy(header->magic, tt_file_magic, sizeof(tt_file_magic));
+  header->version = tt_file_version;
+  header->seed = zobrist_seed;
+  header->side_key = side_key;
+  header->entries = hash_entries;
+}
+
+/*
+    Shared memory hash table ("setoption name HashSegment value <name>"):
+
+        tt_shm_header                  (first page)
+        tt entries [header.file.entries]
+
+    Engine processes on one host naming the same POSIX shared memory
+    segment probe and store into a single table. Entries are verified by
+    their xor'ed keys, so the table itself needs no locking.
+
+    Every attached process holds a shared flock() on the segment, which
+    the kernel drops when the process dies. A process getting the lock
+    exclusively is alone and (re)initializes the segment, so one left
+    behind by a crashed process or an older engine version is reused, and
+    the last process leaving removes it.
+
+    flock() can't turn an exclusive lock into a shared one atomically, so
+    the check for being alone, the initialization and the switch to the
+    shared lock happen under a second lock, a POSIX record lock on the
+    first byte (also dropped when its holder dies). The remaining risk is
+    a process not following this protocol (e.g. an engine build from
+    before it, or a manual truncation), which could resize a live segment
+    and make the attached processes fault on its vanished pages.
+*/
+
+// shared memory segment layout version (bump when the header changes)
+#define tt_shm_version 1
+
+// size of the segment header (entries start on a page boundary)
+#define tt_shm_header_size 4096
+
+// shared memory segment header
+typedef struct
+{
+  tt_file_header file;  // entry format, hash keys and number of entries (as in hash files)
+  unsigned int layout;  // segment layout version
+  volatile int ready;   // set once the entries are cleared, reset by the last process leaving
+} tt_shm_header;
+
+// name of the shared memory segment to hold the hash table (empty: private table)
+char hash_segment[256];
+
+// attached segment (descriptor -1: hash table allocated by allocate_large)
+char attached_segment[256];
+int hash_segment_fd = -1;
+tt_shm_header *hash_segment_header = NULL;
+size_t hash_segment_size = 0;
+
+// leave the shared memory segment (the last process removes it)
+void detach_hash_segment()
+{
+#ifndef WIN64
+  // alone on the segment: mark it dead for processes about to attach, then remove it
+  if (flock(hash_segment_fd, LOCK_EX | LOCK_NB) == 0)
+  {
+    hash_segment_header->ready = 0;
+    shm_unlink(attached_segment);
+  }
+
+  munmap(hash_segment_header, hash_segment_size);
+
+  // closing drops the lock
+  close(hash_segment_fd);
+#endif
+
+  hash_segment_fd = -1;
+  hash_segment_header = NULL;
+  hash_segment_size = 0;
+  hash_table = NULL;
+}
+
+#ifndef WIN64
+// take or release the creation lock of a segment (type F_WRLCK or F_UNLCK, waits for the lock)
+int lock_hash_segment(int fd, int type)
+{
+  struct flock lock;
+  memset(&lock, 0, sizeof(lock));
+
+  lock.l_type = type;
+  lock.l_whence = SEEK_SET;
+  lock.l_start = 0;
+  lock.l_len = 1;
+
+  return fcntl(fd, F_SETLKW, &lock);
+}
+#endif
+
+// place the hash table in a shared memory segment, created with the given size in MB by the first process (returns 1 on success)
+int attach_hash_segment(char *name, int mb)
+{
+#ifndef WIN64
+  // expected header (number of entries aside)
+  tt_file_header expected[1];
+  init_hash_file_header(expected);
+
+  // a few attempts in case the segment is removed or its creator dies while we attach
+  for (int attempt = 0; attempt < 8; attempt++)
+  {
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0666);
+
+    if (fd < 0)
+      break;
+
+    // one process at a time decides whether it is alone and initializes the segment
+    // (closing the descriptor on the way out releases this lock as well)
+    if (lock_hash_segment(fd, F_WRLCK) < 0)
+    {
+      close(fd);
+      break;
+    }
+
+    // alone on the segment, otherwise wait for the last process leaving (if any) to let go
+    int alone = flock(fd, LOCK_EX | LOCK_NB) == 0;
+
+    if (!alone && flock(fd, LOCK_SH) < 0)
+    {
+      close(fd);
+      break;
+    }
+
+    // removed by the last process leaving in the meantime: start over
+    struct stat segment_stat;
+
+    if (fstat(fd, &segment_stat) < 0 || segment_stat.st_nlink == 0)
+    {
+      close(fd);
+      continue;
+    }
+
+    // the first process sizes the segment, the others take it as it is
+    u64 entries = (u64)mb * 0x100000 / sizeof(tt);
+    size_t size = alone ? tt_shm_header_size + entries * sizeof(tt) : (size_t)segment_stat.st_size;
+
+    if ((alone && ftruncate(fd, size) < 0) || size < tt_shm_header_size)
+    {
+      close(fd);
+      break;
+    }
+
+    tt_shm_header *header = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (header == MAP_FAILED)
+    {
+      close(fd);
+      break;
+    }
+
+#ifdef MADV_HUGEPAGE
+    // transparent huge pages, if enabled for shared memory
+    madvise(header, size, MADV_HUGEPAGE);
+#endif
+
+    if (alone)
+    {
+      // write header, nobody else may attach before the entries are cleared
+      memset(header, 0, tt_shm_header_size);
+      header->file = *expected;
+      header->file.entries = entries;
+      header->layout = tt_shm_version;
+
+      hash_table = (tt *)((char *)header + tt_shm_header_size);
+      hash_entries = entries;
+      clear_hash_table();
+
+      header->ready = 1;
+
+      // let the others in
+      flock(fd, LOCK_SH);
+    }
+
+    // creator died before clearing the entries: start over
+    else if (!header->ready)
+    {
+      munmap(header, size);
+      close(fd);
+      continue;
+    }
+
+    // reject segments written by another engine version or with other hash keys
+    else
+    {
+      expected->entries = header->file.entries;
+
+      if (memcmp(&header->file, expected, sizeof(tt_file_header)) || header->layout != tt_shm_version ||
+          size != tt_shm_header_size + header->file.entries * sizeof(tt))
+      {
+        fprintf(stderr, "info string shared memory segment %s is used by another engine version\n", name);
+        munmap(header, size);
+        close(fd);
+        return 0;
+      }
+
+      hash_table = (tt *)((char *)header + tt_shm_header_size);
+      hash_entries = header->file.entries;
+    }
+
+    // others may create or attach from here on
+    lock_hash_segment(fd, F_UNLCK);
+
+    // keep segment
+    strncpy(attached_segment, name, sizeof(attached_segment) - 1);
+    hash_segment_fd = fd;
+    hash_segment_header = header;
+    hash_segment_size = size;
+
+    fprintf(stderr, "info string hash table: %llu KB in shared memory segment %s (%s)\n",
+            hash_entries * sizeof(tt) / 1024, name, alone ? "created" : "attached");
+
+    return 1;
+  }
+#endif
+
+  fprintf(stderr, "info string unable to attach shared memory segment %s\n", name);
+
+  return 0;
+}
+
+// (re)allocate the hash table of a given size in MB
+void init_hash_table(int mb)
+{
+  // leave the shared memory segment or free hash table if not empty
+  if (hash_segment_fd >= 0)
+    detach_hash_segment();
+  else if (hash_table != NULL)
+  {
+    free_large(hash_table, hash_entries * sizeof(tt));
+    hash_table = NULL;
+  }
+
+  // a table has at least one MB (an empty one would divide every probe by zero)
+  if (mb < 1)
+    mb = 1;
+
+  // hash table shared with the other engine processes on this host
+  if (*hash_segment && attach_hash_segment(hash_segment, mb))
+    return;
+
+  // init hash size
+  hash_entries = (u64)mb * 0x100000 / sizeof(tt);
+
+  // allocate memory
+  hash_table = (tt *)allocate_large(hash_entries * sizeof(tt), "hash table");
+
+  // not even the smallest table fits
+  if (hash_table == NULL && mb <= 1)
+  {
+    fprintf(stderr, "Couldn't allocate memory for hash table\n");
+    exit(1);
+  }
+
+  // if allocation has failed try again with half the size
+  if (hash_table == NULL)
+  {
+    printf("    Couldn't allocate memory for hash table, trying %dMB...", mb / 2);
+    init_hash_table(mb / 2);
+    return;
+  }
+
+  clear_hash_table();
+}
+
+// private hash table of a server session, handed to its search threads (NULL: the shared table is probed)
+__thread tt *private_hash_table = NULL;
+__thread u64 private_hash_entries = 0;
+
+// (re)allocate the private hash table of the current thread of a given size in MB (0 goes back to the shared table)
+void init_private_hash_table(int mb)
+{
+  if (private_hash_table != NULL)
+    free_large(private_hash_table, private_hash_entries * sizeof(tt));
+
+  private_hash_table = NULL;
+  private_hash_entries = 0;
+
+  if (mb == 0)
+    return;
+
+  private_hash_table = (tt *)allocate_large((u64)mb * 0x100000 / sizeof(tt) * sizeof(tt), "private hash table");
+
+  // stay on the shared table if allocation fails
+  if (private_hash_table == NULL)
+    return;
+
+  private_hash_entries = (u64)mb * 0x100000 / sizeof(tt);
+  memset(private_hash_table, 0, private_hash_entries * sizeof(tt));
+}
+
+// hash table entry of the current position
+static inline tt *get_hash_entry()
+{
+  if (private_hash_table != NULL)
+    return &private_hash_table[hash_key % private_hash_entries];
+
+  return &hash_table[hash_key % hash_entries];
+}
+
+// write hash table to a file (returns 1 on success)
+int save_hash_table(char *path)
+{
+  // init header
+  tt_file_header header[1];
+  init_hash_file_header(header);
+
+  // open file
+  FILE *file = fopen(path, "wb");
+
+  if (file == NULL)
+  {
+    printf("info string unable to write hash file %s\n", path);
+    return 0;
+  }
+
+  // write header & entries
+  int saved = fwrite(header, sizeof(tt_file_header), 1, file) == 1 &&
+              fwrite(hash_table, sizeof(tt), hash_entries, file) == hash_entries;
+
+  // make sure everything reached the file
+  saved = (fclose(file) == 0) && saved;
+
+  printf("info string %s hash file %s (%llu entries)\n", saved ? "saved" : "failed to save", path, hash_entries);
+
+  return saved;
+}
+
+// load hash table from a file written by save_hash_table() (returns 1 on success)
+int load_hash_table(char *path)
+{
+  // expected header
+  tt_file_header expected[1];
+  init_hash_file_header(expected);
+
+#ifdef WIN64
+  // read the whole file into memory
+  FILE *file = fopen(path, "rb");
+
+  if (file == NULL)
+  {
+    printf("info string no hash file %s\n", path);
+    return 0;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  char *memory = malloc(size);
+
+  if (memory == NULL || fread(memory, 1, size, file) != (size_t)size)
+  {
+    printf("info string unable to read hash file %s\n", path);
+    free(memory);
+    fclose(file);
+    return 0;
+  }
+
+  fclose(file);
+#else
+  // map the file, pages are read in as they are copied
+  int file = open(path, O_RDONLY);
+  struct stat file_stat;
+
+  if (file < 0 || fstat(file, &file_stat) < 0)
+  {
+    printf("info string no hash file %s\n", path);
+
+    if (file >= 0)
+      close(file);
+
+    return 0;
+  }
+
+  size_t size = file_stat.st_size;
+
+  char *memory = (size >= sizeof(tt_file_header)) ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+
+  close(file);
+
+  if (memory == MAP_FAILED)
+  {
+    printf("info string unable to read hash file %s\n", path);
+    return 0;
+  }
+#endif
+
+  // init file header
+  tt_file_header *header = (tt_file_header *)memory;
+
+  // reject files written by another engine version or with other hash keys
+  int valid = size >= sizeof(tt_file_header) &&
+              !memcmp(header->magic, expected->magic, sizeof(header->magic)) &&
+              header->version == expected->version &&
+              header->seed == expected->seed &&
+              header->side_key == expected->side_key &&
+              header->entries && (header->entries * sizeof(tt)) % 0x100000 == 0 &&
+              size == sizeof(tt_file_header) + header->entries * sizeof(tt);
+
+  if (valid)
+  {
+    // resize the hash table to the stored one (sizes are whole MBs)
+    if (header->entries != hash_entries)
+      init_hash_table(header->entries * sizeof(tt) / 0x100000);
+
+    // a shared memory segment attached by other processes keeps its size
+    valid = header->entries == hash_entries;
+  }
+
+  if (valid)
+  {
+    // copy entries
+    memcpy(hash_table, memory + sizeof(tt_file_header), hash_entries * sizeof(tt));
+  }
+
+  printf("info string %s hash file %s\n", valid ? "loaded" : "rejected stale", path);
+
+#ifdef WIN64
+  free(memory);
+#else
+  munmap(memory, size);
+#endif
+
+  return valid;
+}
+
+/*
+ *
+ *            Syzygy Tablebases
+ *
+ *  WDL/DTZ probing is done by the Fathom library (github.com/jdart1/Fathom),
+ *  which memory maps the table files so that all engine processes on a host
+ *  share them through the page cache. Build with
+ *
+ *    make syzygy FATHOM=<path to Fathom/src>
+ *
+ *  and point the engine to the tables with "setoption name SyzygyPath value <dir>".
+ *
+ */
+
+#ifdef USE_SYZYGY
+#include "tbprobe.h"
+#endif
+
+// largest number of pieces covered by the loaded tables (0 when none are loaded)
+int tb_largest = 0;
+
+// tablebase hits of the current search
+__thread long tb_hits;
+
+// root moves allowed by the DTZ tables (no filtering when count is 0)
+__thread int root_tb_moves[256];
+__thread int root_tb_count;
+
+// load tablebases from a directory (or several separated by ':', "<empty>" unloads them)
+void init_syzygy(char *path)
+{
+#ifdef USE_SYZYGY
+  tb_init(path);
+  tb_largest = TB_LARGEST;
+
+  printf("info string Syzygy tablebases found for up to %d pieces\n", tb_largest);
+#else
+  (void)path;
+  printf("info string Syzygy support not compiled in\n");
+#endif
+}
+
+#ifdef USE_SYZYGY
+
+// tables use a1 = 0, mirror the board vertically on the way in
+#define tb_bitboard(bitboard) __builtin_bswap64(bitboard)
+
+// tablebase win score (below any real mate score, shortened by the distance from root)
+#define tb_win_score (mate_score - max_ply)
+
+// probe WDL tables, only valid right after a zeroing move and without castling rights
+static inline unsigned probe_wdl()
+{
+  return tb_probe_wdl(tb_bitboard(occupancies[white]),
+                      tb_bitboard(occupancies[black]),
+                      tb_bitboard(bitboards[K] | bitboards[k]),
+                      tb_bitboard(bitboards[Q] | bitboards[q]),
+                      tb_bitboard(bitboards[R] | bitboards[r]),
+                      tb_bitboard(bitboards[B] | bitboards[b]),
+                      tb_bitboard(bitboards[N] | bitboards[n]),
+                      tb_bitboard(bitboards[P] | bitboards[p]),
+                      fifty, castle,
+                      (enpassant == no_sq) ? 0 : mirror_square(enpassant),
+                      side == white);
+}
+
+// Fathom's root (DTZ) probe is not thread safe, batch workers and server sessions take turns
+pthread_mutex_t tb_root_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// restrict root moves to the ones preserving the tablebase result
+void filter_root_moves(moves *move_list)
+{
+  unsigned results[TB_MAX_MOVES];
+
+  // no filtering unless the root position is covered
+  root_tb_count = 0;
+
+  pthread_mutex_lock(&tb_root_lock);
+
+  unsigned result = tb_probe_root(tb_bitboard(occupancies[white]),
+                                  tb_bitboard(occupancies[black]),
+                                  tb_bitboard(bitboards[K] | bitboards[k]),
+                                  tb_bitboard(bitboards[Q] | bitboards[q]),
+                                  tb_bitboard(bitboards[R] | bitboards[r]),
+                                  tb_bitboard(bitboards[B] | bitboards[b]),
+                                  tb_bitboard(bitboards[N] | bitboards[n]),
+                                  tb_bitboard(bitboards[P] | bitboards[p]),
+                                  fifty, castle,
+                                  (enpassant == no_sq) ? 0 : mirror_square(enpassant),
+                                  side == white, results);
+
+  pthread_mutex_unlock(&tb_root_lock);
+
+  if (result == TB_RESULT_FAILED || result == TB_RESULT_CHECKMATE || result == TB_RESULT_STALEMATE)
+    return;
+
+  tb_hits++;
+
+  // best achievable result
+  unsigned best_wdl = TB_GET_WDL(result);
+
+  // fastest zeroing move when winning, slowest when losing
+  unsigned best_dtz = 0;
+  int found = 0;
+
+  for (int index = 0; results[index] != TB_RESULT_FAILED; index++)
+  {
+    if (TB_GET_WDL(results[index]) != best_wdl)
+      continue;
+
+    unsigned dtz = TB_GET_DTZ(results[index]);
+
+    if (!found || (best_wdl > TB_DRAW && dtz < best_dtz) || (best_wdl < TB_DRAW && dtz > best_dtz))
+      best_dtz = dtz;
+
+    found = 1;
+  }
+
+  // promoted piece codes for the side to move [TB_PROMOTES_*]
+  int promotions[5] = {0, Q, R, B, N};
+
+  // keep every move with the best result (and best DTZ unless drawing)
+  for (int index = 0; results[index] != TB_RESULT_FAILED; index++)
+  {
+    if (TB_GET_WDL(results[index]) != best_wdl)
+      continue;
+
+    if (best_wdl != TB_DRAW && TB_GET_DTZ(results[index]) != best_dtz)
+      continue;
+
+    int source_square = mirror_square(TB_GET_FROM(results[index]));
+    int target_square = mirror_square(TB_GET_TO(results[index]));
+    int promoted = promotions[TB_GET_PROMOTES(results[index])];
+
+    if (promoted && side == black)
+      promoted += 6;
+
+    for (int count = 0; count < move_list->count; count++)
+    {
+      int move = move_list->moves[count];
+
+      if (get_move_source(move) == source_square && get_move_target(move) == target_square && get_move_promoted(move) == promoted)
+        root_tb_moves[root_tb_count++] = move;
+    }
+  }
+}
+
+#endif
+
+// is the root move allowed by the tablebases
+static inline int root_move_allowed(int move)
+{
+  // no filtering
+  if (root_tb_count == 0)
+    return 1;
+
+  for (int index = 0; index < root_tb_count; index++)
+  {
+    if (root_tb_moves[index] == move)
+      return 1;
+  }
+
+  return 0;
+}
+
+/*
+ *
+ *                Search
+ *
+ */
+
+// get time in milliseconds
+int get_time_ms()
+{
+#ifdef WIN64
+  return GetTickCount();
+#else
+  struct timeval time_value;
+  gettimeofday(&time_value, NULL);
+  return time_value.tv_sec * 1000 + time_value.tv_usec / 1000;
+#endif
+}
+
+// score bounds
+#define infinity 50000
+#define mate_value 49000
+#define mate_score 48000
+
+// max reachable ply within a search
+#define max_ply 64
+
+// leaf nodes (perft) or visited nodes (search)
+__thread long nodes;
+
+// half move counter
+__thread int ply;
+
+// search limits: fixed stop time and node budget (0 when not set)
+__thread int timeset;
+__thread int stoptime;
+__thread long nodes_limit;
+
+// search interrupted flag
+__thread int stopped;
+
+// UCI client a search reports to: the console or a session of the analysis server
+typedef struct
+{
+  // set by the UCI thread on "stop" / "quit"
+  volatile int stop;
+
+  // set by the UCI thread for "go ponder" / "go infinite", cleared on "ponderhit"
+  volatile int ponder;
+
+  // stream the "info" and "bestmove" lines go to
+  FILE *output;
+} uci_client;
+
+// console client (standard input & output)
+uci_client console_client;
+
+// client of the current thread (UCI thread of a session and its search thread)
+__thread uci_client *client = &console_client;
+
+// searching on the opponent's time (the clock starts on ponderhit)
+__thread int pondering;
+
+// time allowed for the move once the clock is running
+__thread int time_budget;
+
+// print "info" lines and "bestmove" while searching
+__thread int search_output = 1;
+
+// score and depth of the last completed iteration
+__thread int search_score;
+__thread int search_depth;
+
+// killer moves [id][ply] (compact)
+__thread unsigned short killer_moves[2][max_ply];
+
+// history moves [piece][square]
+__thread int history_moves[12][64];
+
+// PV length [ply]
+__thread int pv_length[max_ply];
+
+// PV table [ply][ply] (compact)
+__thread unsigned short pv_table[max_ply][max_ply];
+
+// follow PV & score PV move
+__thread int follow_pv, score_pv;
+
+// per ply search frame
+typedef struct
+{
+  // moves generated at this ply
+  moves move_list;
+
+  // board state before the move being searched from this ply
+  undo_state undo;
+
+  // move being searched from this ply (0 for a null move)
+  int move;
+
+  // hash move left out by the singular extension search at this ply (compact)
+  int excluded_move;
+
+  // extensions on the path from the root to this ply
+  unsigned char check_extensions, singular_extensions, recapture_extensions;
+} search_frame;
+
+// search stack [ply], preallocated per thread instead of ~1 KB move lists on the call stack
+__thread search_frame search_stack[max_ply];
+
+// max number of lines reported in MultiPV mode
+#define max_multi_pv 64
+
+// number of best lines to report ("MultiPV" UCI option of the session)
+__thread int multi_pv = 1;
+
+// root moves already reported as better lines in the current iteration
+__thread unsigned short root_excluded[max_multi_pv];
+__thread int root_excluded_count;
+
+// completed lines of the last iteration [line][ply]
+__thread unsigned short multi_pv_table[max_multi_pv][max_ply];
+__thread int multi_pv_length[max_multi_pv];
+__thread int multi_pv_score[max_multi_pv];
+
+// late move reduction parameters
+const int full_depth_moves = 4;
+const int reduction_limit = 3;
+
+// extensions allowed on a single path from the root
+const int check_extension_budget = 8;
+const int singular_extension_budget = 4;
+const int recapture_extension_budget = 4;
+
+// singular extension parameters (minimal depth, hash entry depth behind it, margin per ply)
+const int singular_depth = 6;
+const int singular_hash_depth = 3;
+const int singular_margin = 4;
+
+// internal iterative reduction: nodes without hash move from this depth on are searched a ply shallower
+const int iir_depth = 4;
+
+// ProbCut parameters (minimal depth, margin above beta, depth of the verification search below the node's)
+const int probcut_depth = 5;
+const int probcut_margin = 100;
+const int probcut_reduction = 4;
+
+// search features toggled by the "IIR" and "ProbCut" UCI options of the session
+__thread int use_iir = 1;
+__thread int use_probcut = 1;
+
+/*
+ *  Correction history: the static evaluation misjudges a pawn structure the
+ *  same way in every position that has it. For the side to move and the
+ *  pawn structure (pawn_key) the table keeps a running average of the gap
+ *  between the search score of a node and its static evaluation, which is
+ *  added to the static evaluation the pruning decisions are based on.
+ */
+
+// correction history entries per side (power of two)
+#define correction_size 16384
+
+// entries hold the gap in 1/256 centipawns
+#define correction_grain 256
+
+// running average weights are out of this scale
+#define correction_weight_scale 256
+
+// largest correction in centipawns
+#define correction_max 64
+
+// search score minus static evaluation [side][pawn key]
+__thread int correction_history[2][correction_size];
+
+// static evaluation adjusted by the correction history
+static inline int corrected_evaluation(int evaluation)
+{
+  return evaluation + correction_history[side][pawn_key & (correction_size - 1)] / correction_grain;
+}
+
+// move the correction of the current pawn structure towards the gap of this node
+static inline void update_correction_history(int evaluation, int score, int depth)
+{
+  int *entry = &correction_history[side][pawn_key & (correction_size - 1)];
+
+  // deeper searches weigh more
+  int weight = (depth + 1 < 16) ? depth + 1 : 16;
+
+  *entry = (*entry * (correction_weight_scale - weight) + (score - evaluation) * correction_grain * weight) / correction_weight_scale;
+
+  // keep the correction within bounds
+  if (*entry > correction_max * correction_grain)
+    *entry = correction_max * correction_grain;
+  if (*entry < -correction_max * correction_grain)
+    *entry = -correction_max * correction_grain;
+}
+
+/*
+ *    (Victims) Pawn Knight Bishop   Rook  Queen   King
+ *  (Attackers)
+ *        Pawn   105    205    305    405    505    605
+ *      Knight   104    204    304    404    504    604
+ *      Bishop   103    203    303    403    503    603
+ *        Rook   102    202    302    402    502    602
+ *       Queen   101    201    301    401    501    601
+ *        King   100    200    300    400    500    600
+ */
+
+// MVV LVA [attacker][victim]
+const int mvv_lva[12][12] = {
+    {105, 205, 305, 405, 505, 605, 105, 205, 305, 405, 505, 605},
+    {104, 204, 304, 404, 504, 604, 104, 204, 304, 404, 504, 604},
+    {103, 203, 303, 403, 503, 603, 103, 203, 303, 403, 503, 603},
+    {102, 202, 302, 402, 502, 602, 102, 202, 302, 402, 502, 602},
+    {101, 201, 301, 401, 501, 601, 101, 201, 301, 401, 501, 601},
+    {100, 200, 300, 400, 500, 600, 100, 200, 300, 400, 500, 600},
+
+    {105, 205, 305, 405, 505, 605, 105, 205, 305, 405, 505, 605},
+    {104, 204, 304, 404, 504, 604, 104, 204, 304, 404, 504, 604},
+    {103, 203, 303, 403, 503, 603, 103, 203, 303, 403, 503, 603},
+    {102, 202, 302, 402, 502, 602, 102, 202, 302, 402, 502, 602},
+    {101, 201, 301, 401, 501, 601, 101, 201, 301, 401, 501, 601},
+    {100, 200, 300, 400, 500, 600, 100, 200, 300, 400, 500, 600}};
+
+// convert move to UCI notation (e.g. "e7e8q"), buffer must hold 6 chars
+char *move_to_uci(int move, char *buffer)
+{
+  int source_square = get_move_source(move);
+  int target_square = get_move_target(move);
+
+  buffer[0] = 'a' + source_square % 8;
+  buffer[1] = '8' - source_square / 8;
+  buffer[2] = 'a' + target_square % 8;
+  buffer[3] = '8' - target_square / 8;
+  buffer[4] = get_move_promoted(move) ? promoted_pieces[get_move_promoted(move)] : '\0';
+  buffer[5] = '\0';
+
+  return buffer;
+}
+
+// convert compact move to UCI notation, no board needed (PV lines, ponder move)
+char *packed_move_to_uci(int packed, char *buffer)
+{
+  int source_square = get_packed_source(packed);
+  int target_square = get_packed_target(packed);
+
+  buffer[0] = 'a' + source_square % 8;
+  buffer[1] = '8' - source_square / 8;
+  buffer[2] = 'a' + target_square % 8;
+  buffer[3] = '8' - target_square / 8;
+  buffer[4] = (get_packed_special(packed) == special_promotion) ? "nbrq"[get_packed_promotion(packed)] : '\0';
+  buffer[5] = '\0';
+
+  return buffer;
+}
+
+// read hash entry data
+static inline int read_hash_entry(int alpha, int beta, int *best_move, int depth)
+{
+  // init hash entry pointer to the hash entry responsible for the current position
+  tt *hash_entry = get_hash_entry();
+
+  // read the entry once, a concurrent write shows up as a key mismatch
+  u64 data = hash_entry->data;
+
+  stats_inc(tt_probes);
+
+  // make sure we're dealing with the exact position we need
+  if ((hash_entry->key ^ data) == hash_key)
+  {
+    stats_inc(tt_hits);
+
+    // store best move (also when the score is usable, PV nodes search on and order by it)
+    *best_move = get_hash_move(data);
+
+    // make sure that we match the exact depth our search is now at
+    if (get_hash_depth(data) >= depth)
+    {
+      // extract stored score from TT entry
+      int score = get_hash_score(data);
+
+      // retrieve score independent from the actual path from root node (position) to current node (position)
+      if (score < -mate_score)
+        score += ply;
+      if (score > mate_score)
+        score -= ply;
+
+      // match the exact (PV node) score
+      if (get_hash_flag(data) == hash_flag_exact)
+        return score;
+
+      // match alpha (fail-low node) score
+      if ((get_hash_flag(data) == hash_flag_alpha) && (score <= alpha))
+        return alpha;
+
+      // match beta (fail-high node) score
+      if ((get_hash_flag(data) == hash_flag_beta) && (score >= beta))
+        return beta;
+    }
+  }
+
+  // if hash entry doesn't exist
+  return no_hash_entry;
+}
+
+// read the hash entry data of the current position regardless of depth and bounds (0 if not stored)
+static inline u64 probe_hash_data()
+{
+  tt *hash_entry = get_hash_entry();
+
+  u64 data = hash_entry->data;
+
+  return ((hash_entry->key ^ data) == hash_key) ? data : 0;
+}
+
+// write hash entry data
+static inline void write_hash_entry(int score, int best_move, int depth, int hash_flag)
+{
+  // init hash entry pointer to the hash entry responsible for the current position
+  tt *hash_entry = get_hash_entry();
+
+  // store score independent from the actual path from root node (position) to current node (position)
+  if (score < -mate_score)
+    score -= ply;
+  if (score > mate_score)
+    score += ply;
+
+  // depth field is 6 bits wide
+  if (depth > 63)
+    depth = 63;
+
+  u64 data = encode_hash_data(best_move, hash_flag, depth, score);
+
+  // write hash entry data
+  hash_entry->key = hash_key ^ data;
+  hash_entry->data = data;
+}
+
+// position repetition detection
+static inline int is_repetition()
+{
+  // loop over repetition indicies range
+  for (int index = 0; index < repetition_index; index++)
+  {
+    // if we found the hash key same with a current
+    if (repetition_table[index] == hash_key)
+    {
+      // we found a repetition
+      return 1;
+    }
+  }
+
+  // if no repetition found
+  return 0;
+}
+
+// check search limits (called every 2048 nodes)
+static inline void communicate()
+{
+  // ponderhit: the opponent played the expected move, start the clock now
+  if (pondering && !client->ponder)
+  {
+    pondering = 0;
+    stoptime = get_time_ms() + time_budget;
+  }
+
+  // if stop is requested, time is up or node budget is spent break out of the search
+  if (client->stop || (timeset && !pondering && get_time_ms() > stoptime) || (nodes_limit && nodes >= nodes_limit))
+  {
+    stopped = 1;
+  }
+}
+
+// has the root move been reported as a better line already
+static inline int root_move_excluded(int move)
+{
+  for (int index = 0; index < root_excluded_count; index++)
+  {
+    if (root_excluded[index] == pack_move(move))
+      return 1;
+  }
+
+  return 0;
+}
+
+// count legal root moves the search is allowed to play
+int count_root_moves()
+{
+  // create move list instance
+  moves move_list[1];
+
+  // generate moves
+  generate_moves(move_list);
+
+  // legal moves counter
+  int legal_moves = 0;
+
+  // loop over generated moves
+  for (int count = 0; count < move_list->count; count++)
+  {
+    // preserve board state
+    copy_board();
+
+    // count legal moves allowed by the tablebases
+    if (make_move(move_list->moves[count], all_moves) && root_move_allowed(move_list->moves[count]))
+      legal_moves++;
+
+    // take move back
+    take_back();
+  }
+
+  return legal_moves;
+}
+
+// enable PV move scoring
+static inline void enable_pv_scoring(moves *move_list)
+{
+  // disable following PV
+  follow_pv = 0;
+
+  // loop over the moves within a move list
+  for (int count = 0; count < move_list->count; count++)
+  {
+    // make sure we hit PV move
+    if (pv_table[0][ply] == pack_move(move_list->moves[count]))
+    {
+      // enable move scoring
+      score_pv = 1;
+
+      // enable following PV
+      follow_pv = 1;
+    }
+  }
+}
+
+/*  =======================
+         Move ordering
+    =======================
+
+    1. PV move
+    2. Captures in MVV/LVA
+    3. 1st killer move
+    4. 2nd killer move
+    5. History moves
+    6. Unsorted moves
+*/
+
+// score moves
+static inline int score_move(int move)
+{
+  // if PV move scoring is allowed
+  if (score_pv)
+  {
+    // make sure we are dealing with PV move
+    if (pv_table[0][ply] == pack_move(move))
+    {
+      // disable score PV flag
+      score_pv = 0;
+
+      // give PV move the highest score to search it first
+      return 20000;
+    }
+  }
+
+  // score capture move
+  if (get_move_capture(move))
+  {
+    // init target piece (enpassant captures a pawn)
+    int target_piece = P;
+
+    // pick up bitboard piece index ranges depending on side
+    int start_piece, end_piece;
+
+    // pick up side to move
+    if (side == white)
+    {
+      start_piece = p;
+      end_piece = k;
+    }
+    else
+    {
+      start_piece = P;
+      end_piece = K;
+    }
+
+    // loop over bitboards opposite to the current side to move
+    for (int bb_piece = start_piece; bb_piece <= end_piece; bb_piece++)
+    {
+      // if there's a piece on the target square
+      if (get_bit(bitboards[bb_piece], get_move_target(move)))
+      {
+        // store the captured piece
+        target_piece = bb_piece;
+        break;
+      }
+    }
+
+    // score move by MVV LVA lookup [source piece][target piece]
+    return mvv_lva[get_move_piece(move)][target_piece] + 10000;
+  }
+
+  // score quiet move
+  else
+  {
+    // score 1st killer move
+    if (killer_moves[0][ply] == pack_move(move))
+      return 9000;
+
+    // score 2nd killer move
+    else if (killer_moves[1][ply] == pack_move(move))
+      return 8000;
+
+    // score history move
+    else
+      return history_moves[get_move_piece(move)][get_move_target(move)];
+  }
+
+  return 0;
+}
+
+// sort moves in descending order (compact hash move first)
+static inline void sort_moves(moves *move_list, int best_move)
+{
+  // move scores
+  int move_scores[256];
+
+  // score all the moves within a move list
+  for (int count = 0; count < move_list->count; count++)
+  {
+    // if hash move available
+    if (best_move == pack_move(move_list->moves[count]))
+      move_scores[count] = 30000;
+
+    else
+      move_scores[count] = score_move(move_list->moves[count]);
+  }
+
+  // insertion sort on move scores
+  for (int current = 1; current < move_list->count; current++)
+  {
+    int move = move_list->moves[current];
+    int score = move_scores[current];
+    int next = current - 1;
+
+    while (next >= 0 && move_scores[next] < score)
+    {
+      move_scores[next + 1] = move_scores[next];
+      move_list->moves[next + 1] = move_list->moves[next];
+      next--;
+    }
+
+    move_scores[next + 1] = score;
+    move_list->moves[next + 1] = move;
+  }
+}
+
+// quiescence search
+static inline int quiescence(int alpha, int beta)
+{
+  // every 2047 nodes
+  if ((nodes & 2047) == 0)
+    // check search limits
+    communicate();
+
+  // increment nodes count
+  nodes++;
+
+  // we are too deep, hence there's an overflow of arrays relying on max ply constant
+  if (ply > max_ply - 1)
+    // evaluate position
+    return cached_evaluate();
+
+  // evaluate position
+  int evaluation = cached_evaluate();
+
+  // fail-hard beta cutoff
+  if (evaluation >= beta)
+  {
+    // node (position) fails high
+    return beta;
+  }
+
+  // found a better move
+  if (evaluation > alpha)
+  {
+    // PV node (position)
+    alpha = evaluation;
+  }
+
+  // move list of this ply
+  moves *move_list = &search_stack[ply].move_list;
+
+  // generate captures only, quiet moves would be rejected by make_move anyway
+  generate_captures(move_list);
+
+  // sort moves
+  sort_moves(move_list, 0);
+
+  // loop over moves within a movelist
+  for (int count = 0; count < move_list->count; count++)
+  {
+    // preserve board state
+    copy_board();
+
+    // increment ply
+    ply++;
+
+    // increment repetition index & store hash key
+    repetition_table[repetition_index++] = hash_key;
+
+    // make sure to make only legal moves
+    if (make_move(move_list->moves[count], only_captures) == 0)
+    {
+      // decrement ply
+      ply--;
+
+      // decrement repetition index
+      repetition_index--;
+
+      // take move back
+      take_back();
+
+      // skip to next move
+      continue;
+    }
+
+    // score current move
+    int score = -quiescence(-beta, -alpha);
+
+    // decrement ply
+    ply--;
+
+    // decrement repetition index
+    repetition_index--;
+
+    // take move back
+    take_back();
+
+    // reutrn 0 if time is up
+    if (stopped)
+      return 0;
+
+    // found a better move
+    if (score > alpha)
+    {
+      // PV node (position)
+      alpha = score;
+
+      // fail-hard beta cutoff
+      if (score >= beta)
+      {
+        // node (position) fails high
+        return beta;
+      }
+    }
+  }
+
+  // node (position) fails low
+  return alpha;
+}
+
+// negamax alpha beta search
+// count the extension taken by the move leading to the current ply on top of the ones of the path
+static inline void extend_path(int check, int singular, int recapture)
+{
+  search_frame *frame = &search_stack[ply], *parent = &search_stack[ply - 1];
+
+  frame->check_extensions = parent->check_extensions + check;
+  frame->singular_extensions = parent->singular_extensions + singular;
+  frame->recapture_extensions = parent->recapture_extensions + recapture;
+
+  // nothing left out in the new position
+  frame->excluded_move = 0;
+}
+
+static inline int negamax(int alpha, int beta, int depth)
+{
+  // we are too deep, hence there's an overflow of arrays relying on max ply constant
+  // (checked before any per ply access; extensions can carry depth up to here, so the
+  // last ply is never expanded and children never index past it)
+  if (ply >= max_ply - 1)
+    // evaluate position
+    return cached_evaluate();
+
+  // init PV length
+  pv_length[ply] = ply;
+
+  // variable to store current move's score (from the static evaluation perspective)
+  int score;
+
+  // compact best move (to store in TT)
+  int best_move = 0;
+
+  // define hash flag
+  int hash_flag = hash_flag_alpha;
+
+  // if position repetition occurs or the fifty move rule applies
+  if ((ply && is_repetition()) || fifty >= 100)
+    // return draw score
+    return 0;
+
+  // a hack by Pedro Castro to figure out whether the current node is PV node or not
+  int pv_node = beta - alpha > 1;
+
+  // hash move left out when verifying that it is singular (the hash entry doesn't apply then)
+  int excluded_move = search_stack[ply].excluded_move;
+
+  // read hash entry if we're not in a root ply and hash entry is available
+  // and current node is not a PV node
+  if (ply && !excluded_move && (score = read_hash_entry(alpha, beta, &best_move, depth)) != no_hash_entry && !pv_node)
+    // if the move has already been searched (hence has a value)
+    // we just return the score for this move without searching it
+    return score;
+
+  // every 2047 nodes
+  if ((nodes & 2047) == 0)
+    // check search limits
+    communicate();
+
+  // recursion escape condition
+  if (depth == 0)
+    // run quiescence search
+    return quiescence(alpha, beta);
+
+#ifdef USE_SYZYGY
+  // tablebase cutoff (WDL tables are probed right after zeroing moves without castling rights)
+  if (ply && !excluded_move && fifty == 0 && castle == 0 && count_bits(occupancies[both]) <= tb_largest)
+  {
+    unsigned wdl = probe_wdl();
+
+    if (wdl != TB_RESULT_FAILED)
+    {
+      tb_hits++;
+
+      // cursed wins and blessed losses are draws under the fifty move rule
+      score = (wdl == TB_WIN) ? tb_win_score - ply : (wdl == TB_LOSS) ? -tb_win_score + ply : 0;
+
+      // store the exact result so it is never searched again
+      write_hash_entry(score, 0, max_ply - 1, hash_flag_exact);
+
+      return score;
+    }
+  }
+#endif
+
+  // increment nodes count
+  nodes++;
+
+  // is king in check
+  int in_check = is_square_attacked((side == white) ? get_lsb1st_index(bitboards[K]) : get_lsb1st_index(bitboards[k]), side ^ 1);
+
+  // internal iterative reduction: without a hash move this is likely no important node, search it shallower
+  if (use_iir && ply && depth >= iir_depth && !best_move && !excluded_move)
+    depth--;
+
+  // legal moves counter
+  int legal_moves = 0;
+
+  // static evaluation and its corrected value (not used in check)
+  int raw_eval = 0, static_eval = 0;
+
+  if (!in_check)
+  {
+    raw_eval = cached_evaluate();
+    static_eval = corrected_evaluation(raw_eval);
+  }
+
+  // static evaluation based pruning outside of check and PV nodes (and of singular move verification,
+  // quiescence would count the excluded move as an alternative)
+  if (!in_check && !pv_node && !excluded_move)
+  {
+    // evaluation pruning / static null move pruning
+    if (depth < 3 && abs(beta - 1) > -infinity + 100)
+    {
+      // define evaluation margin
+      int eval_margin = 120 * depth;
+
+      // evaluation margin substracted from static evaluation score fails high
+      if (static_eval - eval_margin >= beta)
+        // evaluation margin substracted from static evaluation score
+        return static_eval - eval_margin;
+    }
+
+    // null move pruning (only when standing pat already holds)
+    if (depth >= 3 && ply && static_eval >= beta)
+    {
+      // preserve board state
+      copy_board();
+
+      // no move to recapture after a null move
+      search_stack[ply].move = 0;
+
+      // increment ply
+      ply++;
+
+      // no extension for a null move
+      extend_path(0, 0, 0);
+
+      // increment repetition index & store hash key
+      repetition_table[repetition_index++] = hash_key;
+
+      // hash enpassant if available
+      if (enpassant != no_sq)
+        hash_key ^= enpassant_keys[enpassant];
+
+      // reset enpassant capture square
+      enpassant = no_sq;
+
+      // switch the side, literally giving opponent an extra move to make
+      side ^= 1;
+
+      // hash the side
+      hash_key ^= side_key;
+
+      // search moves with reduced depth to find beta cutoffs
+      // depth - 1 - R where R is a reduction limit
+      score = -negamax(-beta, -beta + 1, depth - 1 - 2);
+
+      // decrement ply
+      ply--;
+
+      // decrement repetition index
+      repetition_index--;
+
+      // restore board state
+      take_back();
+
+      // reutrn 0 if time is up
+      if (stopped)
+        return 0;
+
+      // fail-hard beta cutoff
+      if (score >= beta)
+        // node (position) fails high
+        return beta;
+    }
+
+    // razoring
+    if (depth <= 3)
+    {
+      // get static eval and add first bonus
+      score = static_eval + 125;
+
+      // define new score
+      int new_score;
+
+      // static evaluation indicates a fail-low node
+      if (score < beta)
+      {
+        // on depth 1
+        if (depth == 1)
+        {
+          // get quiscence score
+          new_score = quiescence(alpha, beta);
+
+          // return quiescence score if it's greater then static evaluation score
+          return (new_score > score) ? new_score : score;
+        }
+
+        // add second bonus to static evaluation
+        score += 175;
+
+        // static evaluation indicates a fail-low node
+        if (score < beta && depth <= 2)
+        {
+          // get quiscence score
+          new_score = quiescence(alpha, beta);
+
+          // quiescence score indicates fail-low node
+          if (new_score < beta)
+            // return quiescence score if it's greater then static evaluation score
+            return (new_score > score) ? new_score : score;
+        }
+      }
+    }
+  }
+
+  // ProbCut: a capture beating beta by a margin in a shallow search will most likely beat beta in a full one
+  if (use_probcut && !pv_node && !in_check && !excluded_move && depth >= probcut_depth && abs(beta) < mate_score / 2)
+  {
+    int probcut_beta = beta + probcut_margin;
+
+    // captures of this ply in MVV/LVA order
+    moves *move_list = &search_stack[ply].move_list;
+    generate_captures(move_list);
+    sort_moves(move_list, best_move);
+
+    for (int count = 0; count < move_list->count; count++)
+    {
+      int move = move_list->moves[count];
+
+      // preserve board state
+      copy_board();
+
+      // remember the move searched from this ply
+      search_stack[ply].move = move;
+
+      // increment ply
+      ply++;
+
+      // increment repetition index & store hash key
+      repetition_table[repetition_index++] = hash_key;
+
+      // make sure to make only legal moves
+      if (make_move(move, all_moves) == 0)
+      {
+        ply--;
+        repetition_index--;
+        take_back();
+        continue;
+      }
+
+      // no extension in the ProbCut search
+      extend_path(0, 0, 0);
+
+      // quiescence search first, verify the captures that pass with a reduced depth search
+      score = -quiescence(-probcut_beta, -probcut_beta + 1);
+
+      if (score >= probcut_beta)
+        score = -negamax(-probcut_beta, -probcut_beta + 1, depth - probcut_reduction);
+
+      // decrement ply
+      ply--;
+
+      // decrement repetition index
+      repetition_index--;
+
+      // take move back
+      take_back();
+
+      // reutrn 0 if time is up
+      if (stopped)
+        return 0;
+
+      // the capture beats beta by the margin: the node fails high
+      if (score >= probcut_beta)
+      {
+        stats_inc(probcut_cutoffs);
+
+        write_hash_entry(beta, pack_move(move), depth - probcut_reduction + 1, hash_flag_beta);
+
+        return beta;
+      }
+    }
+  }
+
+  // singular extension: the hash move is the only good move if all the others
+  // fail low against a margin below its score in a reduced depth search
+  int singular_move = 0;
+
+  if (ply && depth >= singular_depth && !excluded_move && best_move &&
+      search_stack[ply].singular_extensions < singular_extension_budget)
+  {
+    u64 data = probe_hash_data();
+    int hash_score = get_hash_score(data);
+
+    // the hash move comes from a deep enough search failing high or exact
+    if (get_hash_move(data) == best_move && get_hash_depth(data) >= depth - singular_hash_depth &&
+        get_hash_flag(data) != hash_flag_alpha && abs(hash_score) < mate_score)
+    {
+      int singular_beta = hash_score - singular_margin * depth;
+
+      // the exclusion search must not stop this node from following the PV
+      int following_pv = follow_pv, scoring_pv = score_pv;
+
+      // search the other moves only
+      search_stack[ply].excluded_move = best_move;
+      score = negamax(singular_beta - 1, singular_beta, (depth - 1) / 2);
+      search_stack[ply].excluded_move = 0;
+
+      // the exclusion search used this ply's PV
+      pv_length[ply] = ply;
+      follow_pv = following_pv, score_pv = scoring_pv;
+
+      // reutrn 0 if time is up
+      if (stopped)
+        return 0;
+
+      if (score < singular_beta)
+        singular_move = best_move;
+
+      // multi-cut: another move beats beta as well, the node fails high anyway
+      else if (singular_beta >= beta)
+        return beta;
+    }
+  }
+
+  // move list of this ply
+  moves *move_list = &search_stack[ply].move_list;
+
+  // generate moves, only the ones that may get out of check when in check
+  if (in_check)
+    generate_evasions(move_list);
+  else
+    generate_moves(move_list);
+
+  // if we are now following PV line
+  if (follow_pv)
+    // enable PV move scoring
+    enable_pv_scoring(move_list);
+
+  // sort moves
+  sort_moves(move_list, best_move);
+
+  // number of moves searched in a move list
+  int moves_searched = 0;
+
+  // best move found so far is a capture
+  int best_capture = 0;
+
+  // loop over moves within a movelist
+  for (int count = 0; count < move_list->count; count++)
+  {
+    // init current move
+    int move = move_list->moves[count];
+
+    // skip root moves losing the tablebase result or already reported as better lines
+    if (ply == 0 && (!root_move_allowed(move) || root_move_excluded(move)))
+      continue;
+
+    // skip the hash move while verifying that it is singular
+    if (excluded_move && pack_move(move) == excluded_move)
+      continue;
+
+    // extension candidates: the singular hash move and recaptures on the square just captured on (PV nodes)
+    int singular = singular_move && pack_move(move) == singular_move;
+    int recapture = pv_node && ply && get_move_capture(move) && get_move_capture(search_stack[ply - 1].move) &&
+                    get_move_target(move) == get_move_target(search_stack[ply - 1].move);
+
+    // preserve board state
+    copy_board();
+
+    // remember the move searched from this ply
+    search_stack[ply].move = move;
+
+    // increment ply
+    ply++;
+
+    // increment repetition index & store hash key
+    repetition_table[repetition_index++] = hash_key;
+
+    // make sure to make only legal moves
+    if (make_move(move, all_moves) == 0)
+    {
+      // decrement ply
+      ply--;
+
+      // decrement repetition index
+      repetition_index--;
+
+      // take move back
+      take_back();
+
+      // skip to next move
+      continue;
+    }
+
+    // increment legal moves
+    legal_moves++;
+
+    // does the move give check
+    int gives_check = is_square_attacked((side == white) ? get_lsb1st_index(bitboards[K]) : get_lsb1st_index(bitboards[k]), side ^ 1);
+
+    // extend by one ply at most, within the budgets of the path
+    int check = 0;
+
+    if (singular)
+      stats_inc(singular_extensions);
+
+    else if (gives_check && search_stack[ply - 1].check_extensions < check_extension_budget)
+    {
+      check = 1;
+      stats_inc(check_extensions);
+    }
+
+    else if (recapture && search_stack[ply - 1].recapture_extensions < recapture_extension_budget)
+      stats_inc(recapture_extensions);
+
+    else
+      recapture = 0;
+
+    extend_path(check, singular, recapture);
+
+    // depth of the move's subtree
+    int new_depth = depth - 1 + check + singular + recapture;
+
+    // full depth search
+    if (moves_searched == 0)
+      // do normal alpha beta search
+      score = -negamax(-beta, -alpha, new_depth);
+
+    // late move reduction (LMR)
+    else
+    {
+      // condition to consider LMR
+      if (
+          moves_searched >= full_depth_moves &&
+          depth >= reduction_limit &&
+          in_check == 0 &&
+          get_move_capture(move) == 0 &&
+          get_move_promoted(move) == 0)
+        // search current move with reduced depth:
+        score = -negamax(-alpha - 1, -alpha, new_depth - 1);
+
+      // hack to ensure that full-depth search is done
+      else
+        score = alpha + 1;
+
+      // principle variation search (PVS)
+      if (score > alpha)
+      {
+        /* Once you've found a move with a score that is between alpha and beta,
+           the rest of the moves are searched with the goal of proving that they are all bad.
+           It's possible to do this a bit faster than a search that worries that one
+           of the remaining moves might be good. */
+        score = -negamax(-alpha - 1, -alpha, new_depth);
+
+        /* If the algorithm finds out that it was wrong, and that one of the
+           subsequent moves was better than the first PV move, it has to search again,
+           in the normal alpha-beta manner. */
+        if ((score > alpha) && (score < beta))
+          score = -negamax(-beta, -alpha, new_depth);
+      }
+    }
+
+    // decrement ply
+    ply--;
+
+    // decrement repetition index
+    repetition_index--;
+
+    // take move back
+    take_back();
+
+    // reutrn 0 if time is up
+    if (stopped)
+      return 0;
+
+    // increment the counter of moves searched so far
+    moves_searched++;
+
+    // found a better move
+    if (score > alpha)
+    {
+      // switch hash flag from storing score for fail-low node
+      // to the one storing score for PV node
+      hash_flag = hash_flag_exact;
+
+      // store compact best move (for TT, PV and killers)
+      best_move = pack_move(move);
+      best_capture = get_move_capture(move);
+
+      // on quiet moves
+      if (get_move_capture(move) == 0)
+        // store history moves
+        history_moves[get_move_piece(move)][get_move_target(move)] += depth;
+
+      // PV node (position)
+      alpha = score;
+
+      // write PV move
+      pv_table[ply][ply] = best_move;
+
+      // loop over the next ply
+      for (int next_ply = ply + 1; next_ply < pv_length[ply + 1]; next_ply++)
+        // copy move from deeper ply into a current ply's line
+        pv_table[ply][next_ply] = pv_table[ply + 1][next_ply];
+
+      // adjust PV length
+      pv_length[ply] = pv_length[ply + 1];
+
+      // fail-hard beta cutoff
+      if (score >= beta)
+      {
+        stats_inc(beta_cutoffs);
+
+        // cutoff produced by the first move searched
+        if (moves_searched == 1)
+          stats_inc(first_move_cutoffs);
+
+        // store hash entry with the score equal to beta (not for a position with a move left out)
+        if (!excluded_move)
+          write_hash_entry(beta, best_move, depth, hash_flag_beta);
+
+        // learn from quiet fail-highs above the static evaluation
+        if (!in_check && !excluded_move && get_move_capture(move) == 0 && beta > static_eval && beta < mate_score / 2)
+          update_correction_history(raw_eval, beta, depth);
+
+        // on quiet moves
+        if (get_move_capture(move) == 0)
+        {
+          // store killer moves
+          killer_moves[1][ply] = killer_moves[0][ply];
+          killer_moves[0][ply] = best_move;
+        }
+
+        // node (position) fails high
+        return beta;
+      }
+    }
+  }
+
+  // we don't have any legal moves to make in the current postion
+  if (legal_moves == 0)
+  {
+    // the only legal move was left out: it is singular
+    if (excluded_move)
+      return alpha;
+
+    // king is in check
+    if (in_check)
+      // return mating score (assuming closest distance to mating position)
+      return -mate_value + ply;
+
+    // king is not in check
+    else
+      // return stalemate score
+      return 0;
+  }
+
+  // no hash entry nor correction for a position with a move left out
+  if (excluded_move)
+    return alpha;
+
+  // store hash entry with the score equal to alpha (unless some root moves were left out)
+  if (ply || root_excluded_count == 0)
+    write_hash_entry(alpha, best_move, depth, hash_flag);
+
+  // learn from exact scores after quiet best moves and from fail-lows below the static evaluation
+  if (!in_check && abs(alpha) < mate_score / 2 &&
+      ((hash_flag == hash_flag_exact && !best_capture) ||
+       (hash_flag == hash_flag_alpha && alpha < static_eval)))
+    update_correction_history(raw_eval, alpha, depth);
+
+  // node (position) fails low
+  return alpha;
+}
+
+// convert search score to UCI notation ("cp 25" or "mate 3"), buffer must hold 16 chars
+char *score_to_uci(int score, char *buffer)
+{
+  // getting mated (mate 0: mated in the position itself)
+  if (score >= -mate_value && score < -mate_score)
+    sprintf(buffer, "mate %d", -(score + mate_value) / 2);
+
+  // delivering mate
+  else if (score > mate_score && score < mate_value)
+    sprintf(buffer, "mate %d", (mate_value - score) / 2 + 1);
+
+  else
+    sprintf(buffer, "cp %d", score);
+
+  return buffer;
+}
+
+// search position for the best move (iterative deepening)
+int search_position(int depth)
+{
+  // search start time
+  int start = get_time_ms();
+
+  // define best score variable
+  int score = 0;
+
+  // best move of the last completed iteration (compact)
+  int best_move = 0;
+
+  // move & score string buffers
+  char move_string[6], score_string[16];
+
+  // reset nodes counter
+  nodes = 0;
+
+  // reset hot path counters
+  reset_stats();
+
+  // reset tablebase hits and root move filter
+  tb_hits = 0;
+  root_tb_count = 0;
+
+#ifdef USE_SYZYGY
+  // root position covered by the tablebases: only search moves preserving the result
+  if (castle == 0 && count_bits(occupancies[both]) <= tb_largest)
+  {
+    moves move_list[1];
+    generate_moves(move_list);
+    filter_root_moves(move_list);
+  }
+#endif
+
+  // reset "time is up" flag
+  stopped = 0;
+
+  // reset follow PV flags
+  follow_pv = 0;
+  score_pv = 0;
+
+  // reset last search result
+  search_score = 0;
+  search_depth = 0;
+
+  // clear helper data structures for search
+  memset(killer_moves, 0, sizeof(killer_moves));
+  memset(history_moves, 0, sizeof(history_moves));
+  memset(correction_history, 0, sizeof(correction_history));
+  memset(pv_table, 0, sizeof(pv_table));
+  memset(pv_length, 0, sizeof(pv_length));
+
+  // the root has no extensions and no move left out
+  search_stack[0].check_extensions = search_stack[0].singular_extensions = search_stack[0].recapture_extensions = 0;
+  search_stack[0].excluded_move = 0;
+
+  // define initial alpha beta bounds
+  int alpha = -infinity;
+  int beta = infinity;
+
+  // clamp depth to the arrays relying on max ply constant
+  if (depth > max_ply - 1)
+    depth = max_ply - 1;
+
+  // number of lines to search (there can't be more lines than legal moves)
+  int lines = (multi_pv > 1) ? count_root_moves() : 1;
+
+  if (lines > multi_pv)
+    lines = multi_pv;
+
+  // without legal moves the single line search reports the mate or draw score
+  if (lines < 1)
+    lines = 1;
+
+  // forget lines of the previous search
+  memset(multi_pv_table, 0, sizeof(multi_pv_table));
+  memset(multi_pv_length, 0, sizeof(multi_pv_length));
+  root_excluded_count = 0;
+
+  // iterative deepening
+  for (int current_depth = 1; current_depth <= depth; current_depth++)
+  {
+    // search the lines one after another, each excluding the root moves of the better ones
+    root_excluded_count = 0;
+
+    // line searched again after falling outside its window
+    int full_window = 0;
+
+    for (int line = 0; line < lines; line++)
+    {
+      // follow the line found by the previous iteration
+      if (lines > 1)
+      {
+        memcpy(pv_table[0], multi_pv_table[line], sizeof(pv_table[0]));
+        pv_length[0] = multi_pv_length[line];
+      }
+
+      // enable follow PV flag
+      follow_pv = 1;
+
+      // other lines get a window around their own score from the previous iteration
+      if (line)
+      {
+        alpha = (current_depth > 1 && !full_window) ? multi_pv_score[line] - 50 : -infinity;
+        beta = (current_depth > 1 && !full_window) ? multi_pv_score[line] + 50 : infinity;
+      }
+
+      // find best move within a given position
+      score = negamax(alpha, beta, current_depth);
+
+      // if time is up stop calculating
+      if (stopped)
+        break;
+
+      // we fell outside the window, so try again with a full-width window (and the same depth)
+      if ((score <= alpha) || (score >= beta))
+      {
+        alpha = -infinity;
+        beta = infinity;
+        full_window = 1;
+        line--;
+        continue;
+      }
+
+      // next line starts with a narrow window again
+      full_window = 0;
+
+      // store completed line
+      memcpy(multi_pv_table[line], pv_table[0], sizeof(pv_table[0]));
+      multi_pv_length[line] = pv_length[0];
+      multi_pv_score[line] = score;
+
+      // exclude its root move from the next lines
+      root_excluded[root_excluded_count++] = pv_table[0][0];
+    }
+
+    // keep the last completed iteration
+    if (stopped)
+      break;
+
+    // no root moves excluded between iterations
+    root_excluded_count = 0;
+
+    // set up the window for the next iteration
+    alpha = multi_pv_score[0] - 50;
+    beta = multi_pv_score[0] + 50;
+
+    // remember result of the completed iteration
+    best_move = multi_pv_table[0][0];
+    search_score = multi_pv_score[0];
+    search_depth = current_depth;
+
+    // print search info
+    if (search_output)
+    {
+      // keep the lines whole when the UCI thread answers at the same time
+      flockfile(client->output);
+
+      // loop over lines
+      for (int line = 0; line < lines; line++)
+      {
+        fprintf(client->output, "info score %s depth %d", score_to_uci(multi_pv_score[line], score_string), current_depth);
+
+        // line number is only reported in MultiPV mode
+        if (multi_pv > 1)
+          fprintf(client->output, " multipv %d", line + 1);
+
+        fprintf(client->output, " nodes %ld tbhits %ld time %d pv", nodes, tb_hits, get_time_ms() - start);
+
+        // loop over the moves within a PV line
+        for (int count = 0; count < multi_pv_length[line]; count++)
+        {
+          // print PV move
+          fprintf(client->output, " %s", packed_move_to_uci(multi_pv_table[line][count], move_string));
+        }
+
+        // print new line
+        fprintf(client->output, "\n");
+      }
+
+      fflush(client->output);
+      funlockfile(client->output);
+    }
+  }
+
+  // interrupted within the very first iteration: use the best root move found so far
+  if (best_move == 0)
+    best_move = multi_pv_length[0] ? multi_pv_table[0][0] : pv_table[0][0];
+
+  // otherwise the best line of the last completed iteration gives the ponder move
+  else
+  {
+    memcpy(pv_table[0], multi_pv_table[0], sizeof(pv_table[0]));
+    pv_length[0] = multi_pv_length[0];
+  }
+
+  // UCI forbids bestmove while pondering or searching infinitely until ponderhit / stop
+  while (pondering && client->ponder && !client->stop)
+#ifdef WIN64
+    Sleep(1);
+#else
+    usleep(1000);
+#endif
+
+  // print best move
+  if (search_output)
+  {
+    print_stats();
+
+    flockfile(client->output);
+
+    fprintf(client->output, "bestmove %s", best_move ? packed_move_to_uci(best_move, move_string) : "0000");
+
+    // expected reply to ponder on
+    if (pv_length[0] > 1 && pv_table[0][0] == best_move)
+      fprintf(client->output, " ponder %s", packed_move_to_uci(pv_table[0][1], move_string));
+
+    fprintf(client->output, "\n");
+    fflush(client->output);
+    funlockfile(client->output);
+  }
+
+  // expand to a full move on the root position for the caller
+  return best_move ? unpack_move(best_move) : 0;
+}
+
+/*
+ *
+ *            Mate Search
+ *
+ *  "go mate N" proves a mate in N moves with depth-first proof-number search
+ *  (df-pn) instead of alpha-beta. The attacker to move is an OR node (one
+ *  move has to mate), the defender to move an AND node (every move has to
+ *  get mated). Every node carries two numbers seen from its side to move:
+ *
+ *    phi     leaves left to prove a win  (proof number at OR nodes, disproof number at AND nodes)
+ *    delta   leaves left to prove a loss (the other one)
+ *
+ *  The search keeps descending into the child with the smallest delta as
+ *  long as the numbers of the node stay below thresholds derived from its
+ *  siblings, so it always expands the most proving node without keeping
+ *  the tree in memory. The numbers live in a node table of fixed size
+ *  ("setoption name MateHash", one per search thread) keyed by the position
+ *  hash key and the plies left (linear probing over a window of 16 entries).
+ *  A node finding its window full replaces the entry with the least work
+ *  searched below it. Once the table is 3/4 full, or replacements pile up,
+ *  the half of the entries with the least work is collected.
+ *
+ *  Mate lengths are tried from 1 move up, so the first proof found is a
+ *  shortest one. Repetitions and the fifty move rule are not considered.
+ *
+ */
+
+// default mate search node table size in MB
+#define default_mate_hash_size 16
+
+// proof / disproof number of a solved node
+#define mate_infinity 0x3fffffffU
+
+// entries probed for a node from its home slot on (linear probing)
+#define mate_probe_window 16
+
+// node table entry
+typedef struct
+{
+  u64 key;              // hash key xor'ed with the plies left key
+  unsigned int phi;     // proof number of the side to move
+  unsigned int delta;   // disproof number of the side to move
+  unsigned int work;    // nodes searched below the entry, 0 for a free entry
+  unsigned short move;  // most proving move (compact)
+} mate_entry;
+
+// node table size in MB ("MateHash" UCI option, per session, handed to its search threads)
+__thread int mate_hash_size = default_mate_hash_size;
+
+// node table of the current thread, its number of entries and the size it was allocated with
+__thread mate_entry *mate_table = NULL;
+__thread u64 mate_entries = 0;
+__thread int mate_table_mb = 0;
+
+// entries in use, entries replaced in full probe windows since the last collection
+__thread u64 mate_table_used = 0, mate_replacements = 0;
+
+// garbage collections and entries collected during the current search
+__thread long mate_gc_runs, mate_gc_freed;
+
+// child keys of the nodes on the current path [ply][child]
+__thread u64 mate_child_keys[max_ply][256];
+
+// (re)allocate the node table of a given size in MB
+void init_mate_table(int mb)
+{
+  if (mate_table != NULL)
+    free_large(mate_table, mate_entries * sizeof(mate_entry));
+
+  // largest power of two number of entries within the size
+  mate_entries = 1;
+  while (mate_entries * 2 * sizeof(mate_entry) <= (u64)mb * 0x100000)
+    mate_entries *= 2;
+
+  mate_table = allocate_large(mate_entries * sizeof(mate_entry), "mate table");
+  mate_table_mb = mb;
+
+  if (mate_table == NULL)
+    mate_entries = 0;
+}
+
+// release the node table of the current thread (before the thread exits)
+void free_mate_table()
+{
+  if (mate_table != NULL)
+    free_large(mate_table, mate_entries * sizeof(mate_entry));
+
+  mate_table = NULL;
+  mate_entries = 0;
+  mate_table_mb = 0;
+}
+
+// forget all nodes
+void clear_mate_table()
+{
+  memset(mate_table, 0, mate_entries * sizeof(mate_entry));
+  mate_table_used = mate_replacements = 0;
+}
+
+// free the entries with the least work below them, about half of the used ones
+void collect_mate_table()
+{
+  // number of used entries by bit length of their work
+  u64 histogram[33] = {0};
+
+  for (u64 index = 0; index < mate_entries; index++)
+  {
+    if (mate_table[index].work)
+      histogram[32 - __builtin_clz(mate_table[index].work)]++;
+  }
+
+  // entries to free: all with a shorter work bit length than the cutoff, some with the cutoff length
+  u64 target = mate_table_used / 2 + 1;
+  u64 shorter = 0;
+  int cutoff = 1;
+
+  while (cutoff < 32 && shorter + histogram[cutoff] < target)
+    shorter += histogram[cutoff++];
+
+  u64 partial = target - shorter;
+
+  for (u64 index = 0; index < mate_entries; index++)
+  {
+    if (mate_table[index].work == 0)
+      continue;
+
+    int length = 32 - __builtin_clz(mate_table[index].work);
+
+    if (length < cutoff || (length == cutoff && partial && partial--))
+    {
+      mate_table[index].work = 0;
+      mate_table_used--;
+      mate_gc_freed++;
+    }
+  }
+
+  mate_replacements = 0;
+  mate_gc_runs++;
+}
+
+// find the entry of a node (NULL if not in the table)
+static inline mate_entry *probe_mate_entry(u64 key)
+{
+  for (int index = 0; index < mate_probe_window; index++)
+  {
+    mate_entry *entry = &mate_table[(key + index) & (mate_entries - 1)];
+
+    if (entry->work && entry->key == key)
+      return entry;
+  }
+
+  return NULL;
+}
+
+// store numbers of a node
+static inline void write_mate_entry(u64 key, unsigned int phi, unsigned int delta, u64 work, int move)
+{
+  // make room before the table overflows
+  if (mate_table_used >= mate_entries / 4 * 3)
+    collect_mate_table();
+
+  mate_entry *entry = &mate_table[key & (mate_entries - 1)];
+
+  for (int index = 0; index < mate_probe_window; index++)
+  {
+    mate_entry *slot = &mate_table[(key + index) & (mate_entries - 1)];
+
+    // same node
+    if (slot->work && slot->key == key)
+    {
+      entry = slot;
+      break;
+    }
+
+    // free entries go first, then the ones with the least work
+    if (slot->work < entry->work)
+      entry = slot;
+  }
+
+  // window full: replace the entry with the least work, unless replacements pile up (nodes pushing each other out)
+  if (entry->work && entry->key != key && ++mate_replacements > mate_entries / 64)
+  {
+    collect_mate_table();
+
+    for (int index = 0; index < mate_probe_window && entry->work; index++)
+    {
+      mate_entry *slot = &mate_table[(key + index) & (mate_entries - 1)];
+
+      if (slot->work == 0)
+        entry = slot;
+    }
+  }
+
+  if (entry->work == 0)
+    mate_table_used++;
+
+  entry->key = key;
+  entry->phi = phi;
+  entry->delta = delta;
+  entry->work = work < 0xffffffff ? work : 0xffffffff;
+  entry->move = move;
+}
+
+// phi & delta of a node, 1 & 1 when it has not been searched yet
+static inline void read_mate_numbers(u64 key, unsigned int *phi, unsigned int *delta)
+{
+  mate_entry *entry = probe_mate_entry(key);
+
+  *phi = entry ? entry->phi : 1;
+  *delta = entry ? entry->delta : 1;
+}
+
+// generate the children of a node that are not solved yet into the search stack, returns the number of legal moves
+static inline int expand_mate_node(int plies)
+{
+  moves *move_list = &search_stack[ply].move_list;
+  u64 *child_keys = mate_child_keys[ply];
+
+  generate_moves(move_list);
+
+  int legal_moves = 0, children = 0;
+
+  for (int move_count = 0; move_count < move_list->count; move_count++)
+  {
+    int move = move_list->moves[move_count];
+
+    // preserve board state
+    copy_board();
+
+    // skip illegal moves
+    if (!make_move(move, all_moves))
+    {
+      take_back();
+      continue;
+    }
+
+    legal_moves++;
+
+    // the last attacker move has to give check (the others are disproved, which doesn't change the node)
+    if (plies > 1 || is_square_attacked((side == white) ? get_lsb1st_index(bitboards[K]) : get_lsb1st_index(bitboards[k]), side ^ 1))
+    {
+      move_list->moves[children] = move;
+      child_keys[children++] = hash_key ^ mate_depth_keys[plies - 1];
+    }
+
+    take_back();
+  }
+
+  move_list->count = children;
+
+  return legal_moves;
+}
+
+// df-pn search of the current position (OR node for an odd number of plies left)
+static void mate_mid(u64 key, int plies, unsigned int phi_threshold, unsigned int delta_threshold)
+{
+  nodes++;
+
+  // check search limits every 2048 nodes
+  if ((nodes & 2047) == 0)
+    communicate();
+
+  long start_nodes = nodes;
+
+  // work searched below the node on earlier visits
+  mate_entry *entry = probe_mate_entry(key);
+  u64 work = entry ? entry->work : 0;
+
+  // is king in check
+  int in_check = is_square_attacked((side == white) ? get_lsb1st_index(bitboards[K]) : get_lsb1st_index(bitboards[k]), side ^ 1);
+
+  // the defender escaped the mate: not in check when the attacker is out of moves, or stalemated
+  int escaped = 0;
+
+  if (plies == 0)
+    escaped = !in_check || expand_mate_node(1) > 0;
+  else if (!(plies & 1) && !in_check)
+    escaped = expand_mate_node(plies) == 0;
+  else
+    expand_mate_node(plies);
+
+  if (escaped)
+  {
+    write_mate_entry(key, 0, mate_infinity, work + 1, 0);
+    return;
+  }
+
+  moves *move_list = &search_stack[ply].move_list;
+  u64 *child_keys = mate_child_keys[ply];
+
+  unsigned int phi, delta;
+  int best = 0;
+
+  while (1)
+  {
+    // phi is the smallest delta of the children, delta the sum of their phi
+    unsigned int second_delta = mate_infinity, best_phi = 0;
+
+    phi = mate_infinity;
+    delta = 0;
+
+    for (int child = 0; child < move_list->count; child++)
+    {
+      unsigned int child_phi, child_delta;
+      read_mate_numbers(child_keys[child], &child_phi, &child_delta);
+
+      delta += child_phi;
+
+      if (delta > mate_infinity)
+        delta = mate_infinity;
+
+      if (child_delta < phi)
+      {
+        second_delta = phi;
+        phi = child_delta;
+        best_phi = child_phi;
+        best = child;
+      }
+      else if (child_delta < second_delta)
+        second_delta = child_delta;
+    }
+
+    // solved, thresholds exceeded or search interrupted
+    if (phi >= phi_threshold || delta >= delta_threshold || stopped)
+      break;
+
+    // preserve board state
+    copy_board();
+
+    make_move(move_list->moves[best], all_moves);
+
+    // search most proving child within thresholds leaving room for its siblings
+    ply++;
+    mate_mid(child_keys[best], plies - 1, delta_threshold - delta + best_phi,
+             phi_threshold < second_delta + 1 ? phi_threshold : second_delta + 1);
+    ply--;
+
+    take_back();
+  }
+
+  write_mate_entry(key, phi, delta, work + nodes - start_nodes + 1, move_list->count ? pack_move(move_list->moves[best]) : 0);
+}
+
+// is the side to move of a node proven lost
+static inline int mate_node_lost(u64 key)
+{
+  mate_entry *entry = probe_mate_entry(key);
+
+  return entry && entry->delta == 0;
+}
+
+// size of the proof tree of a node (0 if not proven or interrupted), PV in pv_table[ply]
+static long mate_proof(u64 key, int plies)
+{
+  // OR node: the attacker has to win, AND node: the defender has to lose
+  int or_node = plies & 1;
+
+  // solve the node again if it was collected
+  mate_entry *entry = probe_mate_entry(key);
+
+  if (entry == NULL || (or_node ? entry->phi : entry->delta) != 0)
+  {
+    mate_mid(key, plies, mate_infinity, mate_infinity);
+    entry = probe_mate_entry(key);
+  }
+
+  // interrupted or no mate
+  if (stopped || entry == NULL || (or_node ? entry->phi : entry->delta) != 0)
+    return 0;
+
+  pv_length[ply] = ply;
+
+  // checkmate
+  if (plies == 0)
+    return 1;
+
+  expand_mate_node(plies);
+
+  moves *move_list = &search_stack[ply].move_list;
+  u64 *child_keys = mate_child_keys[ply];
+
+  long size = 1, longest = -1;
+
+  for (int child = 0; child < move_list->count; child++)
+  {
+    // the attacker plays a child proven lost for the defender, looked up first and solved again if collected
+    if (or_node && !mate_node_lost(child_keys[child]))
+    {
+      int proven = 0;
+
+      for (int other = child + 1; other < move_list->count && !proven; other++)
+        proven = mate_node_lost(child_keys[other]);
+
+      if (proven)
+        continue;
+    }
+
+    int move = move_list->moves[child];
+
+    // preserve board state
+    copy_board();
+
+    make_move(move, all_moves);
+
+    ply++;
+    long child_size = mate_proof(child_keys[child], plies - 1);
+    ply--;
+
+    take_back();
+
+    // interrupted
+    if (stopped)
+      return 0;
+
+    // not proven: the attacker tries the next child
+    if (child_size == 0 && or_node)
+      continue;
+
+    size += child_size;
+
+    // the PV follows the defence with the largest proof tree
+    if (child_size > longest)
+    {
+      longest = child_size;
+
+      pv_table[ply][ply] = pack_move(move);
+
+      for (int next_ply = ply + 1; next_ply < pv_length[ply + 1]; next_ply++)
+        pv_table[ply][next_ply] = pv_table[ply + 1][next_ply];
+
+      pv_length[ply] = pv_length[ply + 1];
+    }
+
+    // the attacker needs a single mating move
+    if (or_node)
+      break;
+  }
+
+  return size;
+}
+
+// prove the shortest mate in up to a given number of moves (prints info & bestmove)
+int mate_search(int mate_moves)
+{
+  // search start time
+  int start = get_time_ms();
+
+  // move string buffer
+  char move_string[6];
+
+  // reset nodes counter and "time is up" flag
+  nodes = 0;
+  stopped = 0;
+
+  // node table sized by the current option, cleared for every search
+  if (mate_table == NULL || mate_table_mb != mate_hash_size)
+    init_mate_table(mate_hash_size);
+
+  clear_mate_table();
+  mate_gc_runs = mate_gc_freed = 0;
+
+  memset(pv_table, 0, sizeof(pv_table));
+  memset(pv_length, 0, sizeof(pv_length));
+
+  // clamp mate length to the plies the search stack holds
+  if (mate_moves > max_ply / 2)
+    mate_moves = max_ply / 2;
+
+  int best_move = 0, mate_length = 0;
+  long proof_size = 0;
+
+  // try mate lengths from 1 move up
+  for (int moves_left = 1; moves_left <= mate_moves && !stopped && mate_entries; moves_left++)
+  {
+    int plies = moves_left * 2 - 1;
+    u64 key = hash_key ^ mate_depth_keys[plies];
+
+    mate_mid(key, plies, mate_infinity, mate_infinity);
+
+    mate_entry *entry = probe_mate_entry(key);
+
+    // most proving move so far
+    if (entry && entry->move)
+      best_move = entry->move;
+
+    int time = get_time_ms() - start;
+
+    fprintf(client->output, "info depth %d nodes %ld time %d nps %ld hashfull %d\n", plies, nodes, time,
+           time ? nodes * 1000 / time : 0, (int)(mate_table_used * 1000 / mate_entries));
+
+    // proven: collect proof tree & PV
+    if (entry && entry->phi == 0)
+    {
+      long search_nodes = nodes;
+
+      proof_size = mate_proof(key, plies);
+
+      // proof extraction is not counted as search
+      nodes = search_nodes;
+
+      if (stopped)
+        break;
+
+      mate_length = moves_left;
+      best_move = pv_table[0][0];
+
+      break;
+    }
+  }
+
+  int time = get_time_ms() - start;
+
+  // keep the lines whole when the UCI thread answers at the same time
+  flockfile(client->output);
+
+  if (mate_length)
+  {
+    fprintf(client->output, "info depth %d score mate %d nodes %ld time %d nps %ld pv", mate_length * 2 - 1, mate_length, nodes, time,
+           time ? nodes * 1000 / time : 0);
+
+    for (int count = 0; count < pv_length[0]; count++)
+      fprintf(client->output, " %s", packed_move_to_uci(pv_table[0][count], move_string));
+
+    fprintf(client->output, "\n");
+    fprintf(client->output, "info string mate in %d proof size %ld nodes %ld nps %ld gc runs %ld freed %ld\n", mate_length, proof_size, nodes,
+           time ? nodes * 1000 / time : 0, mate_gc_runs, mate_gc_freed);
+  }
+  else
+    fprintf(client->output, "info string no mate in %d found%s nodes %ld nps %ld gc runs %ld freed %ld\n", mate_moves, stopped ? " (interrupted)" : "",
+           nodes, time ? nodes * 1000 / time : 0, mate_gc_runs, mate_gc_freed);
+
+  funlockfile(client->output);
+
+  // UCI forbids bestmove while searching infinitely until stop
+  while (pondering && client->ponder && !client->stop)
+#ifdef WIN64
+    Sleep(1);
+#else
+    usleep(1000);
+#endif
+
+  flockfile(client->output);
+
+  fprintf(client->output, "bestmove %s", best_move ? packed_move_to_uci(best_move, move_string) : "0000");
+
+  if (mate_length && pv_length[0] > 1)
+    fprintf(client->output, " ponder %s", packed_move_to_uci(pv_table[0][1], move_string));
+
+  fprintf(client->output, "\n");
+  fflush(client->output);
+  funlockfile(client->output);
+
+  return mate_length;
+}
+
+/*
+ *
+ *            Batch Analysis
+ *
+ */
+
+// max number of positions searched but not yet written out
+#define batch_window 1024
+
+// batch analysis state shared by the worker threads
+typedef struct
+{
+  // EPD/FEN input and result output streams
+  FILE *input;
+  FILE *output;
+
+  // search limits applied to every position
+  int depth;
+  long nodes;
+  int movetime;
+
+  // sequence number of the next position to read and the next result to write
+  long next_position;
+  long next_output;
+
+  // finished results waiting to be written in input order
+  char *results[batch_window];
+
+  // writing a result or starting a worker failed, no more positions are picked up
+  int failed;
+
+  // guards everything above
+  pthread_mutex_t lock;
+
+  // signalled whenever results are written out
+  pthread_cond_t written;
+} batch_info;
+
+// read the next non empty EPD/FEN line of any length into a growing buffer (called with the lock held)
+static int read_batch_line(batch_info *batch, char **line, size_t *size)
+{
+  while (1)
+  {
+    size_t length = 0;
+
+    // read chunks until the line terminator or the end of the stream
+    while (1)
+    {
+      if (*size - length < 2)
+      {
+        char *grown = realloc(*line, *size ? *size * 2 : 1024);
+
+        if (grown == NULL)
+          return 0;
+
+        *line = grown;
+        *size = *size ? *size * 2 : 1024;
+      }
+
+      if (fgets(*line + length, *size - length, batch->input) == NULL)
+        break;
+
+      length += strlen(*line + length);
+
+      if (length && (*line)[length - 1] == '\n')
+        break;
+    }
+
+    // end of the stream
+    if (length == 0)
+      return 0;
+
+    // strip the line terminator
+    (*line)[strcspn(*line, "\r\n")] = '\0';
+
+    // skip blank lines and comments
+    if ((*line)[0] != '\0' && (*line)[0] != '#')
+      return 1;
+  }
+}
+
+// batch worker thread: search positions one at a time until the input is drained
+static void *batch_worker(void *arg)
+{
+  batch_info *batch = (batch_info *)arg;
+
+  // EPD line (grown to the longest line read) and result buffers
+  char *line = NULL, move_string[6], score_string[16];
+  size_t line_size = 0;
+
+  // workers report results only through the output stream
+  search_output = 0;
+
+  while (1)
+  {
+    pthread_mutex_lock(&batch->lock);
+
+    // don't run ahead of the writer by more than the reorder window
+    while (batch->next_position >= batch->next_output + batch_window)
+      pthread_cond_wait(&batch->written, &batch->lock);
+
+    // pick up the next position from the stream
+    if (batch->failed || !read_batch_line(batch, &line, &line_size))
+    {
+      pthread_mutex_unlock(&batch->lock);
+      break;
+    }
+
+    long sequence = batch->next_position++;
+
+    pthread_mutex_unlock(&batch->lock);
+
+    // result line: the EPD record followed by the search result
+    size_t result_size = strlen(line) + 128;
+    char *result = malloc(result_size);
+
+    if (result == NULL)
+    {
+      fprintf(stderr, "batch: out of memory\n");
+      exit(1);
+    }
+
+    // set up the position, records that aren't a legal position are reported instead of searched
+    // (the side not to move can't be in check either)
+    if (!parse_fen(line) ||
+        is_square_attacked(get_lsb1st_index(bitboards[(side == white) ? k : K]), side))
+      snprintf(result, result_size, "%s ; error invalid position\n", line);
+
+    else
+    {
+      // set up search limits
+      int start = get_time_ms();
+
+      timeset = batch->movetime ? 1 : 0;
+      stoptime = start + batch->movetime;
+      nodes_limit = batch->nodes;
+
+      int best_move = search_position(batch->depth);
+
+      snprintf(result, result_size, "%s ; bestmove %s score %s depth %d nodes %ld time %d\n",
+               line,
+               best_move ? move_to_uci(best_move, move_string) : "0000",
+               score_to_uci(search_score, score_string),
+               search_depth, nodes, get_time_ms() - start);
+    }
+
+    pthread_mutex_lock(&batch->lock);
+
+    // park the result in the reorder window
+    batch->results[sequence % batch_window] = result;
+
+    // write out every result that is now in order
+    while (batch->results[batch->next_output % batch_window])
+    {
+      if (fputs(batch->results[batch->next_output % batch_window], batch->output) == EOF)
+        batch->failed = 1;
+
+      free(batch->results[batch->next_output % batch_window]);
+      batch->results[batch->next_output % batch_window] = NULL;
+      batch->next_output++;
+    }
+
+    // a full disk shows up here at the latest
+    if (fflush(batch->output) == EOF)
+      batch->failed = 1;
+
+    pthread_cond_broadcast(&batch->written);
+    pthread_mutex_unlock(&batch->lock);
+  }
+
+  free(line);
+  free_eval_cache();
+
+  return NULL;
+}
+
+/*
+ *  Batch analysis: stream an EPD/FEN file through a pool of search threads
+ *
+ *    esabella batch <file> [depth N] [nodes N] [movetime MS] [threads N] [hash MB] [output FILE]
+ *
+ *  Every worker searches one position at a time, results are written in input order as
+ *
+ *    <epd line> ; bestmove e2e4 score cp 25 depth 8 nodes 123456 time 312
+ *
+ *  Records without board, side and castling fields, or without one king per side,
+ *  are not searched and get "<epd line> ; error invalid position" instead.
+ */
+int batch_analysis(int argc, char *argv[])
+{
+  batch_info batch;
+  memset(&batch, 0, sizeof(batch));
+
+  int threads = 1;
+  int hash_size = default_hash_size;
+  char *output_path = NULL;
+
+  // open EPD/FEN stream ("-" reads standard input)
+  batch.input = strcmp(argv[0], "-") ? fopen(argv[0], "r") : stdin;
+
+  if (batch.input == NULL)
+  {
+    fprintf(stderr, "batch: can't open %s\n", argv[0]);
+    return 1;
+  }
+
+  // parse options
+  for (int index = 1; index + 1 < argc; index += 2)
+  {
+    if (!strcmp(argv[index], "depth"))
+      batch.depth = atoi(argv[index + 1]);
+
+    else if (!strcmp(argv[index], "nodes"))
+      batch.nodes = atol(argv[index + 1]);
+
+    else if (!strcmp(argv[index], "movetime"))
+      batch.movetime = atoi(argv[index + 1]);
+
+    else if (!strcmp(argv[index], "threads"))
+      threads = atoi(argv[index + 1]);
+
+    else if (!strcmp(argv[index], "hash"))
+      hash_size = atoi(argv[index + 1]);
+
+    else if (!strcmp(argv[index], "output"))
+      output_path = argv[index + 1];
+
+    else
+    {
+      fprintf(stderr, "batch: unknown option %s\n", argv[index]);
+      return 1;
+    }
+  }
+
+  // unlimited depth if the search is bounded by nodes or time, fixed depth 6 otherwise
+  if (batch.depth <= 0)
+    batch.depth = (batch.nodes || batch.movetime) ? max_ply : 6;
+
+  if (threads < 1)
+    threads = 1;
+
+  if (hash_size < 1)
+  {
+    fprintf(stderr, "batch: hash must be at least 1 MB\n");
+    return 1;
+  }
+
+  // open result stream
+  batch.output = output_path ? fopen(output_path, "w") : stdout;
+
+  if (batch.output == NULL)
+  {
+    fprintf(stderr, "batch: can't create %s\n", output_path);
+    return 1;
+  }
+
+  // the hash table is allocated once and shared by all positions
+  if (hash_size != default_hash_size)
+    init_hash_table(hash_size);
+
+  pthread_mutex_init(&batch.lock, NULL);
+  pthread_cond_init(&batch.written, NULL);
+
+  int start = get_time_ms();
+
+  // spawn worker pool
+  pthread_t *workers = malloc(threads * sizeof(pthread_t));
+  int started = 0;
+
+  if (workers == NULL)
+    batch.failed = 1;
+
+  while (!batch.failed && started < threads)
+  {
+    if (pthread_create(&workers[started], NULL, batch_worker, &batch) != 0)
+    {
+      // stop the workers already running after their current position
+      pthread_mutex_lock(&batch.lock);
+      batch.failed = 1;
+      pthread_mutex_unlock(&batch.lock);
+
+      fprintf(stderr, "batch: can't start worker thread %d\n", started);
+      break;
+    }
+
+    started++;
+  }
+
+  for (int index = 0; index < started; index++)
+    pthread_join(workers[index], NULL);
+
+  fprintf(stderr, "batch: %ld positions in %d ms\n", batch.next_output, get_time_ms() - start);
+
+  free(workers);
+  pthread_mutex_destroy(&batch.lock);
+  pthread_cond_destroy(&batch.written);
+
+  if (batch.input != stdin)
+    fclose(batch.input);
+
+  // make sure everything reached the file
+  if (batch.output != stdout && fclose(batch.output) != 0)
+    batch.failed = 1;
+
+  if (batch.failed)
+    fprintf(stderr, "batch: analysis incomplete, results missing from %s\n", output_path ? output_path : "stdout");
+
+  return batch.failed;
+}
+
+// search benchmark hash size in MB
+#define bench_hash_size 16
+
+// search benchmark default depth
+#define bench_depth 9
+
+// fixed set of positions for the search benchmark
+char *bench_positions[] = {
+    start_position,
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+    "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+    "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+    "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+    "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+    "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+    "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+    "r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+    "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+    "r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18",
+    "4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22",
+    "3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26",
+    "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/8 b - - 0 1",
+    "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+    "8/8/8/5N2/8/p7/8/2NK3k w - - 0 1",
+    "8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+    "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+    "8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1",
+    "8/8/3P3k/8/1p6/8/1P6/1K3n2 b - - 0 1",
+    "8/R7/2q5/8/6k1/8/1P5p/K6R w - - 0 124",
+    "6k1/3b3r/1p1p4/p1n2p2/1PPNpP1q/P3Q1p1/1R1RB1P1/5K2 b - - 0 1",
+    "r2r1n2/pp2bk2/2p1p2p/3q4/3PN1QP/2P3R1/P4PP1/5RK1 w - - 0 1",
+    "8/8/8/8/8/6k1/6p1/6K1 w - - 0 1",
+    "7k/7P/6K1/8/3B4/8/8/8 b - - 0 1",
+    "5rk1/q6p/2p3bR/1pPp1rP1/1P1Pp3/P3B1Q1/1K3P2/R7 w - - 93 90",
+    "4rrk1/1p1nq3/p7/2p1P1pp/3P2bp/3Q1Bn1/PPPB4/1K2R1NR w - - 40 21",
+    "r3k2r/3nnpbp/q2pp1p1/p7/Pp1PPPP1/4BNN1/1P5P/R2Q1RK1 w kq - 0 16",
+    "3Qb1k1/1r2ppb1/pN1n2q1/Pp1Pp1Pr/4P2p/4BP2/4B1R1/1R5K b - - 11 40",
+    "4k3/3q1r2/1N2r1b1/3ppN2/2nPP3/1B1R2n1/2R1Q3/3K4 w - - 5 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    killer_position,
+    cmk_position};
+
+/*
+ * Search benchmark: fixed depth search of every bench position on one thread
+ * with a cleared hash table of fixed size. The total node count is a signature
+ * of the search behaviour, it changes only when the search itself changes.
+ */
+void search_bench(int depth)
+{
+  int positions = sizeof(bench_positions) / sizeof(bench_positions[0]);
+
+  long total_nodes = 0;
+  int total_time = 0;
+
+  // move string buffer
+  char move_string[6];
+
+  // fixed hash size, no search output
+  init_hash_table(bench_hash_size);
+  search_output = 0;
+
+  eval_cache_hits = eval_cache_misses = 0;
+
+  for (int index = 0; index < positions; index++)
+  {
+    parse_fen(bench_positions[index]);
+
+    // every position starts from an empty hash table (and eval cache)
+    clear_hash_table();
+    clear_eval_cache();
+
+    int start = get_time_ms();
+
+    int best_move = search_position(depth);
+
+    int time = get_time_ms() - start;
+
+    total_nodes += nodes;
+    total_time += time;
+
+    printf("     %3d   Nodes: %9ld   Time: %5d   Best move: %s\n", index + 1, nodes, time, best_move ? move_to_uci(best_move, move_string) : "0000");
+  }
+
+  printf("\n     Depth: %d\n", depth);
+  printf("     Nodes: %ld\n", total_nodes);
+  printf("     Time: %d\n", total_time);
+  printf("     NPS: %ld\n", total_time ? total_nodes * 1000 / total_time : 0);
+  printf("     Eval cache hits: %ld misses: %ld (%.2f%% hits)\n\n", eval_cache_hits, eval_cache_misses,
+         eval_cache_hits + eval_cache_misses ? 100.0 * eval_cache_hits / (eval_cache_hits + eval_cache_misses) : 0.0);
+
+  search_output = 1;
+}
+
+/*
+ *
+ *                Position Batches
+ *
+ *  Throughput mode for tools that evaluate millions of independent positions
+ *  (training data). K positions are stored as a structure of arrays, one
+ *  vector of K bitboards per piece. Move counting and static evaluation then
+ *  run on all lanes at once with GCC vector extensions, so every shift, and
+ *  and popcount step serves K positions. K is the number of 64 bit elements
+ *  of the widest vector register: 2 with SSE2, 4 with AVX2 (make avx2),
+ *  8 with AVX-512.
+ *
+ *  The scalar code looks things up by square (leaper tables, positional
+ *  scores). That would break lockstep, so the batch code uses set-wise
+ *  shifts and bit-sliced score tables instead. Results are exactly
+ *  generate_moves() counts (pseudo legal moves) and evaluate() scores;
+ *  "esabella batchbench" checks both and compares the speed with the
+ *  scalar loop.
+ *
+ */
+
+// positions per batch: one lane per 64 bit element of the widest vector register
+#if defined(__AVX512F__)
+#define batch_lanes 8
+#elif defined(__AVX2__)
+#define batch_lanes 4
+#else
+#define batch_lanes 2
+#endif
+
+// one bitboard per lane (only 16 byte alignment is assumed, so batches can live in malloc'ed memory)
+typedef u64 batch_u64 __attribute__((vector_size(batch_lanes * sizeof(u64)), aligned(16)));
+
+// batch of positions (unused lanes hold empty boards)
+typedef struct
+{
+  batch_u64 bitboards[12];
+  batch_u64 occupancies[3];
+  batch_u64 side;      // all bits set in black to move lanes
+  batch_u64 enpassant; // enpassant square bitboard (0 if none)
+  batch_u64 castle;    // castling rights
+} position_batch;
+
+// bit-sliced positional scores [piece][bit]: squares whose (score - offset) / step has the bit set
+u64 batch_score_planes[12][8];
+
+// positional score offset [piece] (lowest score of the table)
+int batch_score_offset[12];
+
+// number of bit planes [piece]
+int batch_score_bits[12];
+
+// common divisor of all positional scores above their offsets (fewer bit planes)
+int batch_score_step;
+
+// init bit-sliced positional score tables
+void init_batch_tables()
+{
+  // positional scores [piece] (queens have none)
+  const int *tables[6] = {pawn_score, knight_score, bishop_score, rook_score, NULL, king_score};
+
+  // lowest score of every table and the common step
+  batch_score_step = 0;
+
+  for (int piece = P; piece <= K; piece++)
+  {
+    if (tables[piece] == NULL)
+      continue;
+
+    int lowest = tables[piece][0];
+
+    for (int square = 0; square < 64; square++)
+      if (tables[piece][square] < lowest)
+        lowest = tables[piece][square];
+
+    batch_score_offset[piece] = batch_score_offset[piece + 6] = lowest;
+
+    // greatest common divisor with every score above the offset
+    for (int square = 0; square < 64; square++)
+    {
+      int a = batch_score_step, b = tables[piece][square] - lowest;
+
+      while (b)
+      {
+        int rest = a % b;
+        a = b;
+        b = rest;
+      }
+
+      batch_score_step = a;
+    }
+  }
+
+  if (batch_score_step == 0)
+    batch_score_step = 1;
+
+  // slice the scores, black tables are mirrored
+  for (int piece = P; piece <= K; piece++)
+  {
+    if (tables[piece] == NULL)
+      continue;
+
+    for (int square = 0; square < 64; square++)
+    {
+      int value = (tables[piece][square] - batch_score_offset[piece]) / batch_score_step;
+
+      for (int bit = 0; value >> bit; bit++)
+      {
+        if ((value >> bit) & 1)
+        {
+          set_bit(batch_score_planes[piece][bit], square);
+          set_bit(batch_score_planes[piece + 6][bit], mirror_square(square));
+        }
+
+        // bits needed for the score range
+        if (bit >= batch_score_bits[piece])
+          batch_score_bits[piece] = batch_score_bits[piece + 6] = bit + 1;
+      }
+    }
+  }
+}
+
+// copy the current board into a batch lane
+void batch_load(position_batch *batch, int lane)
+{
+  for (int piece = P; piece <= k; piece++)
+    batch->bitboards[piece][lane] = bitboards[piece];
+
+  for (int color = white; color <= both; color++)
+    batch->occupancies[color][lane] = occupancies[color];
+
+  batch->side[lane] = (side == black) ? ~0ULL : 0;
+  batch->enpassant[lane] = (enpassant != no_sq) ? 1ULL << enpassant : 0;
+  batch->castle[lane] = castle;
+}
+
+// count bits of every byte in all lanes (up to 31 of these can be added before batch_sum_bytes)
+static inline batch_u64 batch_byte_counts(batch_u64 bitboard)
+{
+  bitboard -= (bitboard >> 1) & 0x5555555555555555ULL;
+  bitboard = (bitboard & 0x3333333333333333ULL) + ((bitboard >> 2) & 0x3333333333333333ULL);
+
+  return (bitboard + (bitboard >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+}
+
+// add up the byte counters of every lane
+static inline batch_u64 batch_sum_bytes(batch_u64 counts)
+{
+  counts = (counts & 0x00ff00ff00ff00ffULL) + ((counts >> 8) & 0x00ff00ff00ff00ffULL);
+  counts += counts >> 16;
+  counts += counts >> 32;
+
+  return counts & 0xffff;
+}
+
+// count bits in every lane
+static inline batch_u64 batch_popcount(batch_u64 bitboard)
+{
+  return batch_sum_bytes(batch_byte_counts(bitboard));
+}
+
+// pick a where mask is set, b elsewhere
+static inline batch_u64 batch_select(batch_u64 mask, batch_u64 a, batch_u64 b)
+{
+  return (a & mask) | (b & ~mask);
+}
+
+// shift all lanes one step (positive shifts towards higher square indices) and drop wrapped squares
+static inline batch_u64 batch_shift(batch_u64 bitboard, int shift, u64 wrap)
+{
+  return ((shift > 0) ? bitboard << shift : bitboard >> -shift) & wrap;
+}
+
+// Kogge-Stone occluded fill of all lanes, returns attacked squares (blockers included)
+static inline batch_u64 batch_fill(batch_u64 sliders, batch_u64 empty, int shift, u64 wrap)
+{
+  empty &= wrap;
+
+  sliders |= empty & batch_shift(sliders, shift, ~0ULL);
+  empty &= batch_shift(empty, shift, ~0ULL);
+  sliders |= empty & batch_shift(sliders, shift * 2, ~0ULL);
+  empty &= batch_shift(empty, shift * 2, ~0ULL);
+  sliders |= empty & batch_shift(sliders, shift * 4, ~0ULL);
+
+  return batch_shift(sliders, shift, wrap);
+}
+
+// byte counters of moves to targets, promotions on the last rank count 4 times
+static inline batch_u64 batch_promotions(batch_u64 targets, u64 last_rank)
+{
+  batch_u64 promotions = batch_byte_counts(targets & last_rank);
+
+  return batch_byte_counts(targets) + promotions + (promotions << 1);
+}
+
+// attack maps of both sides [side] and slider, knight and king moves of the side to move
+static inline void batch_attacks(position_batch *batch, batch_u64 attacks[2], batch_u64 *piece_moves)
+{
+  // king and ray steps, then knight jumps
+  const int steps[16] = {8, 1, 9, 7, -8, -1, -9, -7, 17, 15, 10, 6, -17, -15, -10, -6};
+  const u64 wraps[16] = {~0ULL, not_a_file, not_a_file, not_h_file, ~0ULL, not_h_file, not_h_file, not_a_file,
+                         not_a_file, not_h_file, not_ab_file, not_hg_file, not_h_file, not_a_file, not_hg_file, not_ab_file};
+
+  batch_u64 empty = ~batch->occupancies[both];
+  batch_u64 black_lanes = batch->side;
+
+  // squares the side to move may move to
+  batch_u64 targets = ~batch_select(black_lanes, batch->occupancies[black], batch->occupancies[white]);
+
+  attacks[white] = attacks[black] = (batch_u64){0};
+  *piece_moves = (batch_u64){0};
+
+  // byte counters of the targets (16 sets of at most 8 per byte between flushes)
+  batch_u64 target_bytes = {0};
+
+  // unrolled, so that every shift count and wrap mask is a constant
+#pragma GCC unroll 16
+  for (int step = 0; step < 16; step++)
+  {
+    // king (or knight) and slider targets [side] along this step
+    batch_u64 leapers[2], rays[2];
+
+    for (int color = white; color <= black; color++)
+    {
+      int offset = (color == white) ? 0 : p;
+
+      // king steps and slider rays (straight on steps 0-1 and 4-5, diagonal otherwise)
+      if (step < 8)
+      {
+        batch_u64 sliders = batch->bitboards[Q + offset] | (((step & 3) < 2) ? batch->bitboards[R + offset] : batch->bitboards[B + offset]);
+
+        leapers[color] = batch_shift(batch->bitboards[K + offset], steps[step], wraps[step]);
+        rays[color] = batch_fill(sliders, empty, steps[step], wraps[step]);
+      }
+
+      // knight jumps
+      else
+      {
+        leapers[color] = batch_shift(batch->bitboards[N + offset], steps[step], wraps[step]);
+        rays[color] = (batch_u64){0};
+      }
+
+      attacks[color] |= leapers[color] | rays[color];
+    }
+
+    // rays of different sliders never overlap along one direction, so every target is one move
+    target_bytes += batch_byte_counts(batch_select(black_lanes, leapers[black], leapers[white]) & targets) +
+                    batch_byte_counts(batch_select(black_lanes, rays[black], rays[white]) & targets);
+
+    if ((step & 7) == 7)
+    {
+      *piece_moves += batch_sum_bytes(target_bytes);
+      target_bytes = (batch_u64){0};
+    }
+  }
+
+  // pawn attacks (pawn moves are counted apart)
+  attacks[white] |= ((batch->bitboards[P] >> 7) & not_a_file) | ((batch->bitboards[P] >> 9) & not_h_file);
+  attacks[black] |= ((batch->bitboards[p] << 7) & not_h_file) | ((batch->bitboards[p] << 9) & not_a_file);
+}
+
+// lanes where the castling right is kept, the path is empty and the king does not pass attacked squares (1 per lane)
+static inline batch_u64 batch_castling(position_batch *batch, int right, u64 path, u64 king_path, batch_u64 enemy_attacks)
+{
+  return (batch_u64)((batch->castle & (u64)right) != 0) &
+         (batch_u64)((batch->occupancies[both] & path) == 0) &
+         (batch_u64)((enemy_attacks & king_path) == 0) & 1;
+}
+
+// count pseudo legal moves of every lane (same count as generate_moves)
+void batch_count_moves(position_batch *batch, int counts[batch_lanes])
+{
+  // promotion and double push ranks
+  const u64 rank_8 = 0xffULL, rank_6 = 0xffULL << 16, rank_3 = 0xffULL << 40, rank_1 = 0xffULL << 56;
+
+  batch_u64 attacks[2], count;
+  batch_u64 empty = ~batch->occupancies[both];
+  batch_u64 black_lanes = batch->side;
+
+  // slider, knight and king moves
+  batch_attacks(batch, attacks, &count);
+
+  // white pawn pushes and captures (white lanes only)
+  batch_u64 pawns = batch->bitboards[P] & ~black_lanes;
+  batch_u64 push = (pawns >> 8) & empty;
+  batch_u64 west = (pawns >> 9) & not_h_file;
+  batch_u64 east = (pawns >> 7) & not_a_file;
+
+  // byte counters of the pawn moves (only one side has pawns in a lane)
+  batch_u64 pawn_bytes = batch_promotions(push, rank_8) + batch_byte_counts(((push & rank_3) >> 8) & empty);
+  pawn_bytes += batch_promotions(west & batch->occupancies[black], rank_8) + batch_promotions(east & batch->occupancies[black], rank_8);
+  pawn_bytes += batch_byte_counts(west & batch->enpassant) + batch_byte_counts(east & batch->enpassant);
+
+  // black pawn pushes and captures (black lanes only)
+  pawns = batch->bitboards[p] & black_lanes;
+  push = (pawns << 8) & empty;
+  west = (pawns << 7) & not_h_file;
+  east = (pawns << 9) & not_a_file;
+
+  pawn_bytes += batch_promotions(push, rank_1) + batch_byte_counts(((push & rank_6) << 8) & empty);
+  pawn_bytes += batch_promotions(west & batch->occupancies[white], rank_1) + batch_promotions(east & batch->occupancies[white], rank_1);
+  pawn_bytes += batch_byte_counts(west & batch->enpassant) + batch_byte_counts(east & batch->enpassant);
+
+  count += batch_sum_bytes(pawn_bytes);
+
+  // castling moves
+  count += (batch_castling(batch, wk, (1ULL << f1) | (1ULL << g1), (1ULL << e1) | (1ULL << f1), attacks[black]) +
+            batch_castling(batch, wq, (1ULL << d1) | (1ULL << c1) | (1ULL << b1), (1ULL << e1) | (1ULL << d1), attacks[black])) &
+           ~black_lanes;
+
+  count += (batch_castling(batch, bk, (1ULL << f8) | (1ULL << g8), (1ULL << e8) | (1ULL << f8), attacks[white]) +
+            batch_castling(batch, bq, (1ULL << d8) | (1ULL << c8) | (1ULL << b8), (1ULL << e8) | (1ULL << d8), attacks[white])) &
+           black_lanes;
+
+  for (int lane = 0; lane < batch_lanes; lane++)
+    counts[lane] = (int)count[lane];
+}
+
+// static evaluation of every lane (same score as evaluate)
+void batch_evaluate(position_batch *batch, int scores[batch_lanes])
+{
+  batch_u64 attacks[2], piece_moves, score = {0};
+
+  // byte counters of the bit-sliced positional scores [side][bit]
+  batch_u64 sliced[2][8] = {{{0}}};
+
+  for (int piece = P; piece <= k; piece++)
+  {
+    int color = (piece < p) ? white : black;
+    batch_u64 pieces = batch->bitboards[piece];
+
+    // material and positional score offset
+    int weight = material_score[piece] + ((color == white) ? batch_score_offset[piece] : -batch_score_offset[piece]);
+
+    score += batch_popcount(pieces) * (u64)(long long)weight;
+
+    // count the pieces on every bit plane
+    for (int bit = 0; bit < batch_score_bits[piece]; bit++)
+      sliced[color][bit] += batch_byte_counts(pieces & batch_score_planes[piece][bit]);
+  }
+
+  // weigh the bit planes
+  batch_u64 positional = {0};
+
+  for (int bit = 0; bit < 8; bit++)
+    positional += (batch_sum_bytes(sliced[white][bit]) - batch_sum_bytes(sliced[black][bit])) << bit;
+
+  score += positional * (u64)batch_score_step;
+
+  // attacked squares of both sides (move counts are not needed)
+  batch_attacks(batch, attacks, &piece_moves);
+
+  // score mobility
+  score += (batch_popcount(attacks[white] & ~batch->occupancies[white]) - batch_popcount(attacks[black] & ~batch->occupancies[black])) * (u64)mobility_bonus;
+
+  // score king safety (squares next to the king)
+  batch_u64 king_zone[2] = {{0}, {0}};
+
+#pragma GCC unroll 8
+  for (int step = 0; step < 8; step++)
+  {
+    const int steps[8] = {8, 1, 9, 7, -8, -1, -9, -7};
+    const u64 wraps[8] = {~0ULL, not_a_file, not_a_file, not_h_file, ~0ULL, not_h_file, not_h_file, not_a_file};
+
+    king_zone[white] |= batch_shift(batch->bitboards[K], steps[step], wraps[step]);
+    king_zone[black] |= batch_shift(batch->bitboards[k], steps[step], wraps[step]);
+  }
+
+  score -= batch_popcount(attacks[black] & king_zone[white]) * (u64)king_zone_penalty;
+  score += batch_popcount(attacks[white] & king_zone[black]) * (u64)king_zone_penalty;
+
+  // relative to the side to move
+  score = batch_select(batch->side, -score, score);
+
+  for (int lane = 0; lane < batch_lanes; lane++)
+    scores[lane] = (int)(long long)score[lane];
+}
+
+// batch benchmark default number of positions
+#define batch_bench_positions 100000
+
+// batch benchmark passes over all positions
+#define batch_bench_rounds 10
+
+// restore a stored position into the board (scalar path)
+static inline void batch_bench_restore(undo_state *state)
+{
+  memcpy(bitboards, state->bitboards, sizeof(bitboards));
+  memcpy(occupancies, state->occupancies, sizeof(occupancies));
+  side = state->side;
+  enpassant = state->enpassant;
+  castle = state->castle;
+}
+
+/*
+ * Batch benchmark: collects positions from random playouts of the bench
+ * positions, checks that the batch kernels agree with generate_moves() and
+ * evaluate() on every one of them, then times move counting plus evaluation
+ * of all positions one at a time and batch_lanes at a time.
+ */
+int batch_bench(int positions)
+{
+  if (positions < 1)
+    positions = batch_bench_positions;
+
+  int batches = (positions + batch_lanes - 1) / batch_lanes;
+  int bench_count = sizeof(bench_positions) / sizeof(bench_positions[0]);
+
+  // positions for the scalar path and the same positions in batches
+  undo_state *states = malloc(positions * sizeof(undo_state));
+  position_batch *batch = calloc(batches, sizeof(position_batch));
+
+  if (states == NULL || batch == NULL)
+  {
+    printf("     Not enough memory for %d positions\n", positions);
+    free(states);
+    free(batch);
+    return 1;
+  }
+
+  // fixed seed, every run sees the same positions
+  random_state = zobrist_seed;
+
+  moves move_list[1];
+  int collected = 0;
+
+  // random playouts
+  for (int game = 0; collected < positions; game++)
+  {
+    parse_fen(bench_positions[game % bench_count]);
+
+    for (int move_number = 0; move_number < 100 && collected < positions; move_number++)
+    {
+      // store position
+      memcpy(states[collected].bitboards, bitboards, sizeof(bitboards));
+      memcpy(states[collected].occupancies, occupancies, sizeof(occupancies));
+      states[collected].side = side;
+      states[collected].enpassant = enpassant;
+      states[collected].castle = castle;
+
+      batch_load(&batch[collected / batch_lanes], collected % batch_lanes);
+      collected++;
+
+      // collect legal moves
+      int legal_moves[256], legal = 0;
+
+      generate_moves(move_list);
+
+      for (int count = 0; count < move_list->count; count++)
+      {
+        copy_board();
+
+        if (make_move(move_list->moves[count], all_moves))
+          legal_moves[legal++] = move_list->moves[count];
+
+        take_back();
+      }
+
+      // game over
+      if (legal == 0)
+        break;
+
+      // play a random move
+      copy_board();
+      make_move(legal_moves[get_random_u32_number() % legal], all_moves);
+    }
+  }
+
+  // check the batch results against the scalar ones
+  int counts[batch_lanes], scores[batch_lanes], mismatches = 0;
+
+  for (int index = 0; index < batches; index++)
+  {
+    batch_count_moves(&batch[index], counts);
+    batch_evaluate(&batch[index], scores);
+
+    for (int lane = 0; lane < batch_lanes && index * batch_lanes + lane < positions; lane++)
+    {
+      batch_bench_restore(&states[index * batch_lanes + lane]);
+      generate_moves(move_list);
+
+      if (counts[lane] != move_list->count || scores[lane] != evaluate())
+        mismatches++;
+    }
+  }
+
+  // scalar path
+  long scalar_sum = 0;
+  int start = get_time_ms();
+
+  for (int round = 0; round < batch_bench_rounds; round++)
+  {
+    for (int index = 0; index < positions; index++)
+    {
+      batch_bench_restore(&states[index]);
+      generate_moves(move_list);
+
+      scalar_sum += move_list->count + evaluate();
+    }
+  }
+
+  int scalar_time = get_time_ms() - start;
+
+  // batch path
+  long batch_sum = 0;
+  start = get_time_ms();
+
+  for (int round = 0; round < batch_bench_rounds; round++)
+  {
+    for (int index = 0; index < batches; index++)
+    {
+      batch_count_moves(&batch[index], counts);
+      batch_evaluate(&batch[index], scores);
+
+      for (int lane = 0; lane < batch_lanes && index * batch_lanes + lane < positions; lane++)
+        batch_sum += counts[lane] + scores[lane];
+    }
+  }
+
+  int batch_time = get_time_ms() - start;
+
+  long total = (long)positions * batch_bench_rounds;
+
+  printf("\n     Positions: %d x %d rounds\n", positions, batch_bench_rounds);
+  printf("     Scalar: %6d ms   %9ld positions/s\n", scalar_time, scalar_time ? total * 1000 / scalar_time : 0);
+  printf("     Batch:  %6d ms   %9ld positions/s   (%d lanes)\n", batch_time, batch_time ? total * 1000 / batch_time : 0, batch_lanes);
+  printf("     Speedup: %.2f\n", batch_time ? (double)scalar_time / batch_time : 0.0);
+  printf("     Mismatches: %d%s\n\n", mismatches, scalar_sum == batch_sum ? "" : " (checksums differ)");
+
+  free(states);
+  free(batch);
+
+  return mismatches != 0 || scalar_sum != batch_sum;
+}
+
+/*
+ *
+ *                Self-Play Data Generation
+ *
+ *  esabella gensfen <file> [games N] [nodes N] [depth N] [random N] [threads N] [hash MB] [seed N]
+ *
+ *  Worker threads play games against themselves at a fixed node budget per
+ *  move (5000 by default) after N random opening moves (8 by default). Each
+ *  worker draws its openings from its own xorshift random state seeded
+ *  from the seed. Every searched position is stored with its search score
+ *  and the game result. Positions go into a shared buffer that a writer
+ *  thread streams to disk, so the workers only wait for the disk when it
+ *  falls a whole buffer behind.
+ *
+ */
+
+/*
+    Packed position (32 bytes, little endian host layout)
+
+        u64    occupancy      occupied squares (a8 = bit 0)
+        u8     pieces[16]     piece codes (P = 0 ... k = 11) of the occupied squares
+                              in ascending square order, two per byte, low nibble first
+        u16    state          side | castling << 1 | enpassant file + 1 << 5 | fifty << 9
+        i16    score          search score relative to the side to move (+-32000 at most)
+        u16    move           best move in compact form (pack_move)
+        u16    ply_result     game ply | result << 14 (0 loss, 1 draw, 2 win for the side to move)
+*/
+
+// packed self-play position
+typedef struct
+{
+  u64 occupancy;
+  unsigned char pieces[16];
+  unsigned short state;
+  short score;
+  unsigned short move;
+  unsigned short ply_result;
+} packed_position;
+
+// game results from the side to move's point of view
+#define gensfen_loss 0
+#define gensfen_draw 1
+#define gensfen_win 2
+
+// games are adjudicated as draws after this many plies
+#define gensfen_max_plies 400
+
+// positions per output buffer
+#define gensfen_buffer_size 65536
+
+// self-play state shared by the worker threads and the writer
+typedef struct
+{
+  // output stream
+  FILE *output;
+
+  // search limits applied to every move
+  int depth;
+  long nodes;
+
+  // random opening moves per game
+  int random_plies;
+
+  // number of games to play and games handed out so far
+  long games;
+  long next_game;
+
+  // random seed the worker seeds are derived from
+  unsigned int seed;
+
+  // buffer the workers fill and the one the writer streams out
+  packed_position *filling;
+  packed_position *writing;
+  long filled;
+
+  // positions written and decisive games
+  long positions;
+  long decisive;
+
+  // all workers are done
+  int finished;
+
+  // writing the output failed (e.g. disk full), no more games are started
+  int failed;
+
+  // guards everything above
+  pthread_mutex_t lock;
+
+  // signalled when positions are added or the workers are done
+  pthread_cond_t ready;
+
+  // signalled when the writer takes over the filled buffer
+  pthread_cond_t drained;
+} gensfen_info;
+
+// worker thread arguments
+typedef struct
+{
+  gensfen_info *info;
+  int index;
+} gensfen_worker_args;
+
+// pack the current position
+static void pack_position(packed_position *packed)
+{
+  memset(packed, 0, sizeof(packed_position));
+
+  packed->occupancy = occupancies[both];
+
+  u64 bitboard = occupancies[both];
+
+  // piece codes in square order (at most 32 pieces)
+  for (int index = 0; bitboard && index < 32; index++)
+  {
+    int square = get_lsb1st_index(bitboard);
+
+    for (int piece = P; piece <= k; piece++)
+    {
+      if (get_bit(bitboards[piece], square))
+      {
+        packed->pieces[index / 2] |= piece << ((index & 1) * 4);
+        break;
+      }
+    }
+
+    pop_bit(bitboard, square);
+  }
+
+  packed->state = side | (castle << 1) | ((enpassant != no_sq) ? enpassant % 8 + 1 : 0) << 5 | ((fifty < 127) ? fifty : 127) << 9;
+}
+
+// number of legal moves in the current position
+static int count_legal_moves(int *legal_moves)
+{
+  moves move_list[1];
+  int legal = 0;
+
+  generate_moves(move_list);
+
+  for (int count = 0; count < move_list->count; count++)
+  {
+    copy_board();
+
+    if (make_move(move_list->moves[count], all_moves))
+      legal_moves[legal++] = move_list->moves[count];
+
+    take_back();
+  }
+
+  return legal;
+}
+
+// play a move of the game (kept on the board and in the repetition table)
+static void play_game_move(int move)
+{
+  repetition_table[repetition_index++] = hash_key;
+
+  copy_board();
+  make_move(move, all_moves);
+}
+
+// hand positions of a finished game to the writer
+static void queue_positions(gensfen_info *info, packed_position *positions, int count, int decisive)
+{
+  pthread_mutex_lock(&info->lock);
+
+  // the writer is a whole buffer behind
+  while (info->filled + count > gensfen_buffer_size)
+    pthread_cond_wait(&info->drained, &info->lock);
+
+  memcpy(info->filling + info->filled, positions, count * sizeof(packed_position));
+  info->filled += count;
+  info->decisive += decisive;
+
+  pthread_cond_signal(&info->ready);
+  pthread_mutex_unlock(&info->lock);
+}
+
+// self-play worker: play games until the requested number is handed out
+static void *gensfen_worker(void *arg)
+{
+  gensfen_info *info = ((gensfen_worker_args *)arg)->info;
+  int index = ((gensfen_worker_args *)arg)->index;
+
+  // positions of the current game
+  packed_position game[gensfen_max_plies];
+  int legal_moves[256];
+
+  // own random sequence (xorshift must not start from 0)
+  random_state = (info->seed + index * 0x9e3779b9U) | 1;
+
+  // no search output, fixed node budget
+  search_output = 0;
+  timeset = 0;
+  nodes_limit = info->nodes;
+
+  while (1)
+  {
+    pthread_mutex_lock(&info->lock);
+
+    if (info->next_game >= info->games || info->failed)
+    {
+      pthread_mutex_unlock(&info->lock);
+      break;
+    }
+
+    info->next_game++;
+
+    pthread_mutex_unlock(&info->lock);
+
+    parse_fen(start_position);
+
+    int recorded = 0, loser = -1;
+
+    // random opening (start over if it runs into the end of the game)
+    for (int game_ply = 0; game_ply < info->random_plies; game_ply++)
+    {
+      int legal = count_legal_moves(legal_moves);
+
+      if (legal == 0)
+      {
+        parse_fen(start_position);
+        game_ply = -1;
+        continue;
+      }
+
+      play_game_move(legal_moves[get_random_u64_number() % legal]);
+    }
+
+    for (int game_ply = info->random_plies; game_ply < gensfen_max_plies; game_ply++)
+    {
+      int legal = count_legal_moves(legal_moves);
+
+      // checkmate or stalemate
+      if (legal == 0)
+      {
+        if (is_square_attacked(get_lsb1st_index(bitboards[(side == white) ? K : k]), side ^ 1))
+          loser = side;
+
+        break;
+      }
+
+      // fifty move rule, repetition or bare kings
+      if (fifty >= 100 || is_repetition() || occupancies[both] == (bitboards[K] | bitboards[k]))
+        break;
+
+      int move = search_position(info->depth);
+
+      if (move == 0)
+        break;
+
+      // record the position with its search score
+      packed_position *packed = &game[recorded++];
+
+      pack_position(packed);
+      packed->score = (search_score > 32000) ? 32000 : (search_score < -32000) ? -32000 : search_score;
+      packed->move = pack_move(move);
+      packed->ply_result = game_ply;
+
+      play_game_move(move);
+    }
+
+    // fill in the result from every recorded side's point of view
+    for (int count = 0; count < recorded; count++)
+    {
+      int to_move = game[count].state & 1;
+      int result = (loser == -1) ? gensfen_draw : (loser == to_move) ? gensfen_loss : gensfen_win;
+
+      game[count].ply_result |= result << 14;
+    }
+
+    queue_positions(info, game, recorded, loser != -1);
+  }
+
+  free_eval_cache();
+
+  return NULL;
+}
+
+// self-play writer: stream filled buffers to disk until the workers are done
+static void *gensfen_writer(void *arg)
+{
+  gensfen_info *info = (gensfen_info *)arg;
+
+  pthread_mutex_lock(&info->lock);
+
+  while (1)
+  {
+    while (info->filled == 0 && !info->finished)
+      pthread_cond_wait(&info->ready, &info->lock);
+
+    if (info->filled == 0)
+      break;
+
+    // take over the filled buffer, the workers go on with the empty one
+    packed_position *buffer = info->filling;
+    long count = info->filled;
+
+    info->filling = info->writing;
+    info->writing = buffer;
+    info->filled = 0;
+
+    pthread_cond_broadcast(&info->drained);
+    pthread_mutex_unlock(&info->lock);
+
+    int written = !info->failed && fwrite(buffer, sizeof(packed_position), count, info->output) == (size_t)count;
+
+    pthread_mutex_lock(&info->lock);
+
+    // on a write error later buffers are dropped, so that workers waiting for one finish their game
+    if (written)
+      info->positions += count;
+    else
+      info->failed = 1;
+  }
+
+  pthread_mutex_unlock(&info->lock);
+
+  return NULL;
+}
+
+// self-play data generation
+int gensfen(int argc, char *argv[])
+{
+  gensfen_info info;
+  memset(&info, 0, sizeof(info));
+
+  int threads = 1;
+  int hash_size = default_hash_size;
+
+  info.games = 100;
+  info.nodes = 5000;
+  info.random_plies = 8;
+  info.seed = get_time_ms();
+
+  // parse options
+  for (int index = 1; index + 1 < argc; index += 2)
+  {
+    if (!strcmp(argv[index], "games"))
+      info.games = atol(argv[index + 1]);
+
+    else if (!strcmp(argv[index], "nodes"))
+      info.nodes = atol(argv[index + 1]);
+
+    else if (!strcmp(argv[index], "depth"))
+      info.depth = atoi(argv[index + 1]);
+
+    else if (!strcmp(argv[index], "random"))
+      info.random_plies = atoi(argv[index + 1]);
+
+    else if (!strcmp(argv[index], "threads"))
+      threads = atoi(argv[index + 1]);
+
+    else if (!strcmp(argv[index], "hash"))
+      hash_size = atoi(argv[index + 1]);
+
+    else if (!strcmp(argv[index], "seed"))
+      info.seed = strtoul(argv[index + 1], NULL, 10);
+
+    else
+    {
+      fprintf(stderr, "gensfen: unknown option %s\n", argv[index]);
+      return 1;
+    }
+  }
+
+  // unlimited depth if the search is bounded by nodes
+  if (info.depth <= 0)
+    info.depth = info.nodes ? max_ply : 6;
+
+  if (info.random_plies < 0 || info.random_plies >= gensfen_max_plies)
+    info.random_plies = 0;
+
+  // reject sizes the run can't be set up with
+  if (info.games < 1 || threads < 1 || hash_size < 1)
+  {
+    fprintf(stderr, "gensfen: games, threads and hash must be at least 1\n");
+    return 1;
+  }
+
+  // open output stream
+  info.output = fopen(argv[0], "wb");
+
+  if (info.output == NULL)
+  {
+    fprintf(stderr, "gensfen: can't create %s\n", argv[0]);
+    return 1;
+  }
+
+  // the writer hands whole buffers over, unbuffered writes report a full disk right away
+  setvbuf(info.output, NULL, _IONBF, 0);
+
+  info.filling = malloc(gensfen_buffer_size * sizeof(packed_position));
+  info.writing = malloc(gensfen_buffer_size * sizeof(packed_position));
+
+  pthread_t writer;
+  pthread_t *workers = malloc(threads * sizeof(pthread_t));
+  gensfen_worker_args *args = malloc(threads * sizeof(gensfen_worker_args));
+
+  if (info.filling == NULL || info.writing == NULL || workers == NULL || args == NULL)
+  {
+    fprintf(stderr, "gensfen: out of memory\n");
+    fclose(info.output);
+    free(info.filling);
+    free(info.writing);
+    free(workers);
+    free(args);
+    return 1;
+  }
+
+  // the hash table is shared by all games
+  if (hash_size != default_hash_size)
+    init_hash_table(hash_size);
+
+  pthread_mutex_init(&info.lock, NULL);
+  pthread_cond_init(&info.ready, NULL);
+  pthread_cond_init(&info.drained, NULL);
+
+  int start = get_time_ms();
+
+  // spawn the writer and the worker pool
+  if (pthread_create(&writer, NULL, gensfen_writer, &info) != 0)
+  {
+    fprintf(stderr, "gensfen: can't start the writer thread\n");
+    fclose(info.output);
+    free(info.filling);
+    free(info.writing);
+    free(workers);
+    free(args);
+    return 1;
+  }
+
+  int started = 0, start_failed = 0;
+
+  while (started < threads)
+  {
+    args[started].info = &info;
+    args[started].index = started;
+
+    if (pthread_create(&workers[started], NULL, gensfen_worker, &args[started]) != 0)
+    {
+      // the workers already running stop after their current game
+      pthread_mutex_lock(&info.lock);
+      info.failed = 1;
+      pthread_mutex_unlock(&info.lock);
+
+      fprintf(stderr, "gensfen: can't start worker thread %d\n", started);
+      start_failed = 1;
+      break;
+    }
+
+    started++;
+  }
+
+  for (int index = 0; index < started; index++)
+    pthread_join(workers[index], NULL);
+
+  // let the writer drain the last buffer
+  pthread_mutex_lock(&info.lock);
+  info.finished = 1;
+  pthread_cond_signal(&info.ready);
+  pthread_mutex_unlock(&info.lock);
+
+  pthread_join(writer, NULL);
+
+  // make sure everything reached the file
+  if (fclose(info.output) != 0)
+    info.failed = 1;
+
+  fprintf(stderr, "gensfen: %ld games (%ld decisive), %ld positions in %d ms\n",
+          info.next_game, info.decisive, info.positions, get_time_ms() - start);
+
+  if (info.failed && !start_failed)
+    fprintf(stderr, "gensfen: can't write %s, the file is incomplete\n", argv[0]);
+
+  free(workers);
+  free(args);
+  free(info.filling);
+  free(info.writing);
+  pthread_mutex_destroy(&info.lock);
+  pthread_cond_destroy(&info.ready);
+  pthread_cond_destroy(&info.drained);
+
+  return info.failed;
+}
+
+/*
+ *
+ *           Opening Book
+ *
+ */
+
+/*
+    Polyglot .bin books are sorted arrays of 16 byte big endian entries:
+
+        key     64 bits    Polyglot hash of the position
+        move    16 bits    to file | to row << 3 | from file << 6 | from row << 9 | promotion << 12
+        weight  16 bits    relative move frequency
+        learn   32 bits    unused
+
+    Polyglot hashes use their own fixed random numbers, so the book key is
+    computed from the board state separately from our own Zobrist hash_key.
+*/
+
+// Polyglot random numbers [768 pieces, 4 castling rights, 8 en passant files, side]
+const u64 polyglot_random[781] = {
+    0x9D39247E33776D41ULL, 0x2AF7398005AAA5C7ULL, 0x44DB015024623547ULL, 0x9C15F73E62A76AE2ULL,
+    0x75834465489C0C89ULL, 0x3290AC3A203001BFULL, 0x0FBBAD1F61042279ULL, 0xE83A908FF2FB60CAULL,
+    0x0D7E765D58755C10ULL, 0x1A083822CEAFE02DULL, 0x9605D5F0E25EC3B0ULL, 0xD021FF5CD13A2ED5ULL,
+    0x40BDF15D4A672E32ULL, 0x011355146FD56395ULL, 0x5DB4832046F3D9E5ULL, 0x239F8B2D7FF719CCULL,
+    0x05D1A1AE85B49AA1ULL, 0x679F848F6E8FC971ULL, 0x7449BBFF801FED0BULL, 0x7D11CDB1C3B7ADF0ULL,
+    0x82C7709E781EB7CCULL, 0xF3218F1C9510786CULL, 0x331478F3AF51BBE6ULL, 0x4BB38DE5E7219443ULL,
+    0xAA649C6EBCFD50FCULL, 0x8DBD98A352AFD40BULL, 0x87D2074B81D79217ULL, 0x19F3C751D3E92AE1ULL,
+    0xB4AB30F062B19ABFULL, 0x7B0500AC42047AC4ULL, 0xC9452CA81A09D85DULL, 0x24AA6C514DA27500ULL,
+    0x4C9F34427501B447ULL, 0x14A68FD73C910841ULL, 0xA71B9B83461CBD93ULL, 0x03488B95B0F1850FULL,
+    0x637B2B34FF93C040ULL, 0x09D1BC9A3DD90A94ULL, 0x3575668334A1DD3BULL, 0x735E2B97A4C45A23ULL,
+    0x18727070F1BD400BULL, 0x1FCBACD259BF02E7ULL, 0xD310A7C2CE9B6555ULL, 0xBF983FE0FE5D8244ULL,
+    0x9F74D14F7454A824ULL, 0x51EBDC4AB9BA3035ULL, 0x5C82C505DB9AB0FAULL, 0xFCF7FE8A3430B241ULL,
+    0x3253A729B9BA3DDEULL, 0x8C74C368081B3075ULL, 0xB9BC6C87167C33E7ULL, 0x7EF48F2B83024E20ULL,
+    0x11D505D4C351BD7FULL, 0x6568FCA92C76A243ULL, 0x4DE0B0F40F32A7B8ULL, 0x96D693460CC37E5DULL,
+    0x42E240CB63689F2FULL, 0x6D2BDCDAE2919661ULL, 0x42880B0236E4D951ULL, 0x5F0F4A5898171BB6ULL,
+    0x39F890F579F92F88ULL, 0x93C5B5F47356388BULL, 0x63DC359D8D231B78ULL, 0xEC16CA8AEA98AD76ULL,
+    0x5355F900C2A82DC7ULL, 0x07FB9F855A997142ULL, 0x5093417AA8A7ED5EULL, 0x7BCBC38DA25A7F3CULL,
+    0x19FC8A768CF4B6D4ULL, 0x637A7780DECFC0D9ULL, 0x8249A47AEE0E41F7ULL, 0x79AD695501E7D1E8ULL,
+    0x14ACBAF4777D5776ULL, 0xF145B6BECCDEA195ULL, 0xDABF2AC8201752FCULL, 0x24C3C94DF9C8D3F6ULL,
+    0xBB6E2924F03912EAULL, 0x0CE26C0B95C980D9ULL, 0xA49CD132BFBF7CC4ULL, 0xE99D662AF4243939ULL,
+    0x27E6AD7891165C3FULL, 0x8535F040B9744FF1ULL, 0x54B3F4FA5F40D873ULL, 0x72B12C32127FED2BULL,
+    0xEE954D3C7B411F47ULL, 0x9A85AC909A24EAA1ULL, 0x70AC4CD9F04F21F5ULL, 0xF9B89D3E99A075C2ULL,
+    0x87B3E2B2B5C907B1ULL, 0xA366E5B8C54F48B8ULL, 0xAE4A9346CC3F7CF2ULL, 0x1920C04D47267BBDULL,
+    0x87BF02C6B49E2AE9ULL, 0x092237AC237F3859ULL, 0xFF07F64EF8ED14D0ULL, 0x8DE8DCA9F03CC54EULL,
+    0x9C1633264DB49C89ULL, 0xB3F22C3D0B0B38EDULL, 0x390E5FB44D01144BULL, 0x5BFEA5B4712768E9ULL,
+    0x1E1032911FA78984ULL, 0x9A74ACB964E78CB3ULL, 0x4F80F7A035DAFB04ULL, 0x6304D09A0B3738C4ULL,
+    0x2171E64683023A08ULL, 0x5B9B63EB9CEFF80CULL, 0x506AACF489889342ULL, 0x1881AFC9A3A701D6ULL,
+    0x6503080440750644ULL, 0xDFD395339CDBF4A7ULL, 0xEF927DBCF00C20F2ULL, 0x7B32F7D1E03680ECULL,
+    0xB9FD7620E7316243ULL, 0x05A7E8A57DB91B77ULL, 0xB5889C6E15630A75ULL, 0x4A750A09CE9573F7ULL,
+    0xCF464CEC899A2F8AULL, 0xF538639CE705B824ULL, 0x3C79A0FF5580EF7FULL, 0xEDE6C87F8477609DULL,
+    0x799E81F05BC93F31ULL, 0x86536B8CF3428A8CULL, 0x97D7374C60087B73ULL, 0xA246637CFF328532ULL,
+    0x043FCAE60CC0EBA0ULL, 0x920E449535DD359EULL, 0x70EB093B15B290CCULL, 0x73A1921916591CBDULL,
+    0x56436C9FE1A1AA8DULL, 0xEFAC4B70633B8F81ULL, 0xBB215798D45DF7AFULL, 0x45F20042F24F1768ULL,
+    0x930F80F4E8EB7462ULL, 0xFF6712FFCFD75EA1ULL, 0xAE623FD67468AA70ULL, 0xDD2C5BC84BC8D8FCULL,
+    0x7EED120D54CF2DD9ULL, 0x22FE545401165F1CULL, 0xC91800E98FB99929ULL, 0x808BD68E6AC10365ULL,
+    0xDEC468145B7605F6ULL, 0x1BEDE3A3AEF53302ULL, 0x43539603D6C55602ULL, 0xAA969B5C691CCB7AULL,
+    0xA87832D392EFEE56ULL, 0x65942C7B3C7E11AEULL, 0xDED2D633CAD004F6ULL, 0x21F08570F420E565ULL,
+    0xB415938D7DA94E3CULL, 0x91B859E59ECB6350ULL, 0x10CFF333E0ED804AULL, 0x28AED140BE0BB7DDULL,
+    0xC5CC1D89724FA456ULL, 0x5648F680F11A2741ULL, 0x2D255069F0B7DAB3ULL, 0x9BC5A38EF729ABD4ULL,
+    0xEF2F054308F6A2BCULL, 0xAF2042F5CC5C2858ULL, 0x480412BAB7F5BE2AULL, 0xAEF3AF4A563DFE43ULL,
+    0x19AFE59AE451497FULL, 0x52593803DFF1E840ULL, 0xF4F076E65F2CE6F0ULL, 0x11379625747D5AF3ULL,
+    0xBCE5D2248682C115ULL, 0x9DA4243DE836994FULL, 0x066F70B33FE09017ULL, 0x4DC4DE189B671A1CULL,
+    0x51039AB7712457C3ULL, 0xC07A3F80C31FB4B4ULL, 0xB46EE9C5E64A6E7CULL, 0xB3819A42ABE61C87ULL,
+    0x21A007933A522A20ULL, 0x2DF16F761598AA4FULL, 0x763C4A1371B368FDULL, 0xF793C46702E086A0ULL,
+    0xD7288E012AEB8D31ULL, 0xDE336A2A4BC1C44BULL, 0x0BF692B38D079F23ULL, 0x2C604A7A177326B3ULL,
+    0x4850E73E03EB6064ULL, 0xCFC447F1E53C8E1BULL, 0xB05CA3F564268D99ULL, 0x9AE182C8BC9474E8ULL,
+    0xA4FC4BD4FC5558CAULL, 0xE755178D58FC4E76ULL, 0x69B97DB1A4C03DFEULL, 0xF9B5B7C4ACC67C96ULL,
+    0xFC6A82D64B8655FBULL, 0x9C684CB6C4D24417ULL, 0x8EC97D2917456ED0ULL, 0x6703DF9D2924E97EULL,
+    0xC547F57E42A7444EULL, 0x78E37644E7CAD29EULL, 0xFE9A44E9362F05FAULL, 0x08BD35CC38336615ULL,
+    0x9315E5EB3A129ACEULL, 0x94061B871E04DF75ULL, 0xDF1D9F9D784BA010ULL, 0x3BBA57B68871B59DULL,
+    0xD2B7ADEEDED1F73FULL, 0xF7A255D83BC373F8ULL, 0xD7F4F2448C0CEB81ULL, 0xD95BE88CD210FFA7ULL,
+    0x336F52F8FF4728E7ULL, 0xA74049DAC312AC71ULL, 0xA2F61BB6E437FDB5ULL, 0x4F2A5CB07F6A35B3ULL,
+    0x87D380BDA5BF7859ULL, 0x16B9F7E06C453A21ULL, 0x7BA2484C8A0FD54EULL, 0xF3A678CAD9A2E38CULL,
+    0x39B0BF7DDE437BA2ULL, 0xFCAF55C1BF8A4424ULL, 0x18FCF680573FA594ULL, 0x4C0563B89F495AC3ULL,
+    0x40E087931A00930DULL, 0x8CFFA9412EB642C1ULL, 0x68CA39053261169FULL, 0x7A1EE967D27579E2ULL,
+    0x9D1D60E5076F5B6FULL, 0x3810E399B6F65BA2ULL, 0x32095B6D4AB5F9B1ULL, 0x35CAB62109DD038AULL,
+    0xA90B24499FCFAFB1ULL, 0x77A225A07CC2C6BDULL, 0x513E5E634C70E331ULL, 0x4361C0CA3F692F12ULL,
+    0xD941ACA44B20A45BULL, 0x528F7C8602C5807BULL, 0x52AB92BEB9613989ULL, 0x9D1DFA2EFC557F73ULL,
+    0x722FF175F572C348ULL, 0x1D1260A51107FE97ULL, 0x7A249A57EC0C9BA2ULL, 0x04208FE9E8F7F2D6ULL,
+    0x5A110C6058B920A0ULL, 0x0CD9A497658A5698ULL, 0x56FD23C8F9715A4CULL, 0x284C847B9D887AAEULL,
+    0x04FEABFBBDB619CBULL, 0x742E1E651C60BA83ULL, 0x9A9632E65904AD3CULL, 0x881B82A13B51B9E2ULL,
+    0x506E6744CD974924ULL, 0xB0183DB56FFC6A79ULL, 0x0ED9B915C66ED37EULL, 0x5E11E86D5873D484ULL,
+    0xF678647E3519AC6EULL, 0x1B85D488D0F20CC5ULL, 0xDAB9FE6525D89021ULL, 0x0D151D86ADB73615ULL,
+    0xA865A54EDCC0F019ULL, 0x93C42566AEF98FFBULL, 0x99E7AFEABE000731ULL, 0x48CBFF086DDF285AULL,
+    0x7F9B6AF1EBF78BAFULL, 0x58627E1A149BBA21ULL, 0x2CD16E2ABD791E33ULL, 0xD363EFF5F0977996ULL,
+    0x0CE2A38C344A6EEDULL, 0x1A804AADB9CFA741ULL, 0x907F30421D78C5DEULL, 0x501F65EDB3034D07ULL,
+    0x37624AE5A48FA6E9ULL, 0x957BAF61700CFF4EULL, 0x3A6C27934E31188AULL, 0xD49503536ABCA345ULL,
+    0x088E049589C432E0ULL, 0xF943AEE7FEBF21B8ULL, 0x6C3B8E3E336139D3ULL, 0x364F6FFA464EE52EULL,
+    0xD60F6DCEDC314222ULL, 0x56963B0DCA418FC0ULL, 0x16F50EDF91E513AFULL, 0xEF1955914B609F93ULL,
+    0x565601C0364E3228ULL, 0xECB53939887E8175ULL, 0xBAC7A9A18531294BULL, 0xB344C470397BBA52ULL,
+    0x65D34954DAF3CEBDULL, 0xB4B81B3FA97511E2ULL, 0xB422061193D6F6A7ULL, 0x071582401C38434DULL,
+    0x7A13F18BBEDC4FF5ULL, 0xBC4097B116C524D2ULL, 0x59B97885E2F2EA28ULL, 0x99170A5DC3115544ULL,
+    0x6F423357E7C6A9F9ULL, 0x325928EE6E6F8794ULL, 0xD0E4366228B03343ULL, 0x565C31F7DE89EA27ULL,
+    0x30F5611484119414ULL, 0xD873DB391292ED4FULL, 0x7BD94E1D8E17DEBCULL, 0xC7D9F16864A76E94ULL,
+    0x947AE053EE56E63CULL, 0xC8C93882F9475F5FULL, 0x3A9BF55BA91F81CAULL, 0xD9A11FBB3D9808E4ULL,
+    0x0FD22063EDC29FCAULL, 0xB3F256D8ACA0B0B9ULL, 0xB03031A8B4516E84ULL, 0x35DD37D5871448AFULL,
+    0xE9F6082B05542E4EULL, 0xEBFAFA33D7254B59ULL, 0x9255ABB50D532280ULL, 0xB9AB4CE57F2D34F3ULL,
+    0x693501D628297551ULL, 0xC62C58F97DD949BFULL, 0xCD454F8F19C5126AULL, 0xBBE83F4ECC2BDECBULL,
+    0xDC842B7E2819E230ULL, 0xBA89142E007503B8ULL, 0xA3BC941D0A5061CBULL, 0xE9F6760E32CD8021ULL,
+    0x09C7E552BC76492FULL, 0x852F54934DA55CC9ULL, 0x8107FCCF064FCF56ULL, 0x098954D51FFF6580ULL,
+    0x23B70EDB1955C4BFULL, 0xC330DE426430F69DULL, 0x4715ED43E8A45C0AULL, 0xA8D7E4DAB780A08DULL,
+    0x0572B974F03CE0BBULL, 0xB57D2E985E1419C7ULL, 0xE8D9ECBE2CF3D73FULL, 0x2FE4B17170E59750ULL,
+    0x11317BA87905E790ULL, 0x7FBF21EC8A1F45ECULL, 0x1725CABFCB045B00ULL, 0x964E915CD5E2B207ULL,
+    0x3E2B8BCBF016D66DULL, 0xBE7444E39328A0ACULL, 0xF85B2B4FBCDE44B7ULL, 0x49353FEA39BA63B1ULL,
+    0x1DD01AAFCD53486AULL, 0x1FCA8A92FD719F85ULL, 0xFC7C95D827357AFAULL, 0x18A6A990C8B35EBDULL,
+    0xCCCB7005C6B9C28DULL, 0x3BDBB92C43B17F26ULL, 0xAA70B5B4F89695A2ULL, 0xE94C39A54A98307FULL,
+    0xB7A0B174CFF6F36EULL, 0xD4DBA84729AF48ADULL, 0x2E18BC1AD9704A68ULL, 0x2DE0966DAF2F8B1CULL,
+    0xB9C11D5B1E43A07EULL, 0x64972D68DEE33360ULL, 0x94628D38D0C20584ULL, 0xDBC0D2B6AB90A559ULL,
+    0xD2733C4335C6A72FULL, 0x7E75D99D94A70F4DULL, 0x6CED1983376FA72BULL, 0x97FCAACBF030BC24ULL,
+    0x7B77497B32503B12ULL, 0x8547EDDFB81CCB94ULL, 0x79999CDFF70902CBULL, 0xCFFE1939438E9B24ULL,
+    0x829626E3892D95D7ULL, 0x92FAE24291F2B3F1ULL, 0x63E22C147B9C3403ULL, 0xC678B6D860284A1CULL,
+    0x5873888850659AE7ULL, 0x0981DCD296A8736DULL, 0x9F65789A6509A440ULL, 0x9FF38FED72E9052FULL,
+    0xE479EE5B9930578CULL, 0xE7F28ECD2D49EECDULL, 0x56C074A581EA17FEULL, 0x5544F7D774B14AEFULL,
+    0x7B3F0195FC6F290FULL, 0x12153635B2C0CF57ULL, 0x7F5126DBBA5E0CA7ULL, 0x7A76956C3EAFB413ULL,
+    0x3D5774A11D31AB39ULL, 0x8A1B083821F40CB4ULL, 0x7B4A38E32537DF62ULL, 0x950113646D1D6E03ULL,
+    0x4DA8979A0041E8A9ULL, 0x3BC36E078F7515D7ULL, 0x5D0A12F27AD310D1ULL, 0x7F9D1A2E1EBE1327ULL,
+    0xDA3A361B1C5157B1ULL, 0xDCDD7D20903D0C25ULL, 0x36833336D068F707ULL, 0xCE68341F79893389ULL,
+    0xAB9090168DD05F34ULL, 0x43954B3252DC25E5ULL, 0xB438C2B67F98E5E9ULL, 0x10DCD78E3851A492ULL,
+    0xDBC27AB5447822BFULL, 0x9B3CDB65F82CA382ULL, 0xB67B7896167B4C84ULL, 0xBFCED1B0048EAC50ULL,
+    0xA9119B60369FFEBDULL, 0x1FFF7AC80904BF45ULL, 0xAC12FB171817EEE7ULL, 0xAF08DA9177DDA93DULL,
+    0x1B0CAB936E65C744ULL, 0xB559EB1D04E5E932ULL, 0xC37B45B3F8D6F2BAULL, 0xC3A9DC228CAAC9E9ULL,
+    0xF3B8B6675A6507FFULL, 0x9FC477DE4ED681DAULL, 0x67378D8ECCEF96CBULL, 0x6DD856D94D259236ULL,
+    0xA319CE15B0B4DB31ULL, 0x073973751F12DD5EULL, 0x8A8E849EB32781A5ULL, 0xE1925C71285279F5ULL,
+    0x74C04BF1790C0EFEULL, 0x4DDA48153C94938AULL, 0x9D266D6A1CC0542CULL, 0x7440FB816508C4FEULL,
+    0x13328503DF48229FULL, 0xD6BF7BAEE43CAC40ULL, 0x4838D65F6EF6748FULL, 0x1E152328F3318DEAULL,
+    0x8F8419A348F296BFULL, 0x72C8834A5957B511ULL, 0xD7A023A73260B45CULL, 0x94EBC8ABCFB56DAEULL,
+    0x9FC10D0F989993E0ULL, 0xDE68A2355B93CAE6ULL, 0xA44CFE79AE538BBEULL, 0x9D1D84FCCE371425ULL,
+    0x51D2B1AB2DDFB636ULL, 0x2FD7E4B9E72CD38CULL, 0x65CA5B96B7552210ULL, 0xDD69A0D8AB3B546DULL,
+    0x604D51B25FBF70E2ULL, 0x73AA8A564FB7AC9EULL, 0x1A8C1E992B941148ULL, 0xAAC40A2703D9BEA0ULL,
+    0x764DBEAE7FA4F3A6ULL, 0x1E99B96E70A9BE8BULL, 0x2C5E9DEB57EF4743ULL, 0x3A938FEE32D29981ULL,
+    0x26E6DB8FFDF5ADFEULL, 0x469356C504EC9F9DULL, 0xC8763C5B08D1908CULL, 0x3F6C6AF859D80055ULL,
+    0x7F7CC39420A3A545ULL, 0x9BFB227EBDF4C5CEULL, 0x89039D79D6FC5C5CULL, 0x8FE88B57305E2AB6ULL,
+    0xA09E8C8C35AB96DEULL, 0xFA7E393983325753ULL, 0xD6B6D0ECC617C699ULL, 0xDFEA21EA9E7557E3ULL,
+    0xB67C1FA481680AF8ULL, 0xCA1E3785A9E724E5ULL, 0x1CFC8BED0D681639ULL, 0xD18D8549D140CAEAULL,
+    0x4ED0FE7E9DC91335ULL, 0xE4DBF0634473F5D2ULL, 0x1761F93A44D5AEFEULL, 0x53898E4C3910DA55ULL,
+    0x734DE8181F6EC39AULL, 0x2680B122BAA28D97ULL, 0x298AF231C85BAFABULL, 0x7983EED3740847D5ULL,
+    0x66C1A2A1A60CD889ULL, 0x9E17E49642A3E4C1ULL, 0xEDB454E7BADC0805ULL, 0x50B704CAB602C329ULL,
+    0x4CC317FB9CDDD023ULL, 0x66B4835D9EAFEA22ULL, 0x219B97E26FFC81BDULL, 0x261E4E4C0A333A9DULL,
+    0x1FE2CCA76517DB90ULL, 0xD7504DFA8816EDBBULL, 0xB9571FA04DC089C8ULL, 0x1DDC0325259B27DEULL,
+    0xCF3F4688801EB9AAULL, 0xF4F5D05C10CAB243ULL, 0x38B6525C21A42B0EULL, 0x36F60E2BA4FA6800ULL,
+    0xEB3593803173E0CEULL, 0x9C4CD6257C5A3603ULL, 0xAF0C317D32ADAA8AULL, 0x258E5A80C7204C4BULL,
+    0x8B889D624D44885DULL, 0xF4D14597E660F855ULL, 0xD4347F66EC8941C3ULL, 0xE699ED85B0DFB40DULL,
+    0x2472F6207C2D0484ULL, 0xC2A1E7B5B459AEB5ULL, 0xAB4F6451CC1D45ECULL, 0x63767572AE3D6174ULL,
+    0xA59E0BD101731A28ULL, 0x116D0016CB948F09ULL, 0x2CF9C8CA052F6E9FULL, 0x0B090A7560A968E3ULL,
+    0xABEEDDB2DDE06FF1ULL, 0x58EFC10B06A2068DULL, 0xC6E57A78FBD986E0ULL, 0x2EAB8CA63CE802D7ULL,
+    0x14A195640116F336ULL, 0x7C0828DD624EC390ULL, 0xD74BBE77E6116AC7ULL, 0x804456AF10F5FB53ULL,
+    0xEBE9EA2ADF4321C7ULL, 0x03219A39EE587A30ULL, 0x49787FEF17AF9924ULL, 0xA1E9300CD8520548ULL,
+    0x5B45E522E4B1B4EFULL, 0xB49C3B3995091A36ULL, 0xD4490AD526F14431ULL, 0x12A8F216AF9418C2ULL,
+    0x001F837CC7350524ULL, 0x1877B51E57A764D5ULL, 0xA2853B80F17F58EEULL, 0x993E1DE72D36D310ULL,
+    0xB3598080CE64A656ULL, 0x252F59CF0D9F04BBULL, 0xD23C8E176D113600ULL, 0x1BDA0492E7E4586EULL,
+    0x21E0BD5026C619BFULL, 0x3B097ADAF088F94EULL, 0x8D14DEDB30BE846EULL, 0xF95CFFA23AF5F6F4ULL,
+    0x3871700761B3F743ULL, 0xCA672B91E9E4FA16ULL, 0x64C8E531BFF53B55ULL, 0x241260ED4AD1E87DULL,
+    0x106C09B972D2E822ULL, 0x7FBA195410E5CA30ULL, 0x7884D9BC6CB569D8ULL, 0x0647DFEDCD894A29ULL,
+    0x63573FF03E224774ULL, 0x4FC8E9560F91B123ULL, 0x1DB956E450275779ULL, 0xB8D91274B9E9D4FBULL,
+    0xA2EBEE47E2FBFCE1ULL, 0xD9F1F30CCD97FB09ULL, 0xEFED53D75FD64E6BULL, 0x2E6D02C36017F67FULL,
+    0xA9AA4D20DB084E9BULL, 0xB64BE8D8B25396C1ULL, 0x70CB6AF7C2D5BCF0ULL, 0x98F076A4F7A2322EULL,
+    0xBF84470805E69B5FULL, 0x94C3251F06F90CF3ULL, 0x3E003E616A6591E9ULL, 0xB925A6CD0421AFF3ULL,
+    0x61BDD1307C66E300ULL, 0xBF8D5108E27E0D48ULL, 0x240AB57A8B888B20ULL, 0xFC87614BAF287E07ULL,
+    0xEF02CDD06FFDB432ULL, 0xA1082C0466DF6C0AULL, 0x8215E577001332C8ULL, 0xD39BB9C3A48DB6CFULL,
+    0x2738259634305C14ULL, 0x61CF4F94C97DF93DULL, 0x1B6BACA2AE4E125BULL, 0x758F450C88572E0BULL,
+    0x959F587D507A8359ULL, 0xB063E962E045F54DULL, 0x60E8ED72C0DFF5D1ULL, 0x7B64978555326F9FULL,
+    0xFD080D236DA814BAULL, 0x8C90FD9B083F4558ULL, 0x106F72FE81E2C590ULL, 0x7976033A39F7D952ULL,
+    0xA4EC0132764CA04BULL, 0x733EA705FAE4FA77ULL, 0xB4D8F77BC3E56167ULL, 0x9E21F4F903B33FD9ULL,
+    0x9D765E419FB69F6DULL, 0xD30C088BA61EA5EFULL, 0x5D94337FBFAF7F5BULL, 0x1A4E4822EB4D7A59ULL,
+    0x6FFE73E81B637FB3ULL, 0xDDF957BC36D8B9CAULL, 0x64D0E29EEA8838B3ULL, 0x08DD9BDFD96B9F63ULL,
+    0x087E79E5A57D1D13ULL, 0xE328E230E3E2B3FBULL, 0x1C2559E30F0946BEULL, 0x720BF5F26F4D2EAAULL,
+    0xB0774D261CC609DBULL, 0x443F64EC5A371195ULL, 0x4112CF68649A260EULL, 0xD813F2FAB7F5C5CAULL,
+    0x660D3257380841EEULL, 0x59AC2C7873F910A3ULL, 0xE846963877671A17ULL, 0x93B633ABFA3469F8ULL,
+    0xC0C0F5A60EF4CDCFULL, 0xCAF21ECD4377B28CULL, 0x57277707199B8175ULL, 0x506C11B9D90E8B1DULL,
+    0xD83CC2687A19255FULL, 0x4A29C6465A314CD1ULL, 0xED2DF21216235097ULL, 0xB5635C95FF7296E2ULL,
+    0x22AF003AB672E811ULL, 0x52E762596BF68235ULL, 0x9AEBA33AC6ECC6B0ULL, 0x944F6DE09134DFB6ULL,
+    0x6C47BEC883A7DE39ULL, 0x6AD047C430A12104ULL, 0xA5B1CFDBA0AB4067ULL, 0x7C45D833AFF07862ULL,
+    0x5092EF950A16DA0BULL, 0x9338E69C052B8E7BULL, 0x455A4B4CFE30E3F5ULL, 0x6B02E63195AD0CF8ULL,
+    0x6B17B224BAD6BF27ULL, 0xD1E0CCD25BB9C169ULL, 0xDE0C89A556B9AE70ULL, 0x50065E535A213CF6ULL,
+    0x9C1169FA2777B874ULL, 0x78EDEFD694AF1EEDULL, 0x6DC93D9526A50E68ULL, 0xEE97F453F06791EDULL,
+    0x32AB0EDB696703D3ULL, 0x3A6853C7E70757A7ULL, 0x31865CED6120F37DULL, 0x67FEF95D92607890ULL,
+    0x1F2B1D1F15F6DC9CULL, 0xB69E38A8965C6B65ULL, 0xAA9119FF184CCCF4ULL, 0xF43C732873F24C13ULL,
+    0xFB4A3D794A9A80D2ULL, 0x3550C2321FD6109CULL, 0x371F77E76BB8417EULL, 0x6BFA9AAE5EC05779ULL,
+    0xCD04F3FF001A4778ULL, 0xE3273522064480CAULL, 0x9F91508BFFCFC14AULL, 0x049A7F41061A9E60ULL,
+    0xFCB6BE43A9F2FE9BULL, 0x08DE8A1C7797DA9BULL, 0x8F9887E6078735A1ULL, 0xB5B4071DBFC73A66ULL,
+    0x230E343DFBA08D33ULL, 0x43ED7F5A0FAE657DULL, 0x3A88A0FBBCB05C63ULL, 0x21874B8B4D2DBC4FULL,
+    0x1BDEA12E35F6A8C9ULL, 0x53C065C6C8E63528ULL, 0xE34A1D250E7A8D6BULL, 0xD6B04D3B7651DD7EULL,
+    0x5E90277E7CB39E2DULL, 0x2C046F22062DC67DULL, 0xB10BB459132D0A26ULL, 0x3FA9DDFB67E2F199ULL,
+    0x0E09B88E1914F7AFULL, 0x10E8B35AF3EEAB37ULL, 0x9EEDECA8E272B933ULL, 0xD4C718BC4AE8AE5FULL,
+    0x81536D601170FC20ULL, 0x91B534F885818A06ULL, 0xEC8177F83F900978ULL, 0x190E714FADA5156EULL,
+    0xB592BF39B0364963ULL, 0x89C350C893AE7DC1ULL, 0xAC042E70F8B383F2ULL, 0xB49B52E587A1EE60ULL,
+    0xFB152FE3FF26DA89ULL, 0x3E666E6F69AE2C15ULL, 0x3B544EBE544C19F9ULL, 0xE805A1E290CF2456ULL,
+    0x24B33C9D7ED25117ULL, 0xE74733427B72F0C1ULL, 0x0A804D18B7097475ULL, 0x57E3306D881EDB4FULL,
+    0x4AE7D6A36EB5DBCBULL, 0x2D8D5432157064C8ULL, 0xD1E649DE1E7F268BULL, 0x8A328A1CEDFE552CULL,
+    0x07A3AEC79624C7DAULL, 0x84547DDC3E203C94ULL, 0x990A98FD5071D263ULL, 0x1A4FF12616EEFC89ULL,
+    0xF6F7FD1431714200ULL, 0x30C05B1BA332F41CULL, 0x8D2636B81555A786ULL, 0x46C9FEB55D120902ULL,
+    0xCCEC0A73B49C9921ULL, 0x4E9D2827355FC492ULL, 0x19EBB029435DCB0FULL, 0x4659D2B743848A2CULL,
+    0x963EF2C96B33BE31ULL, 0x74F85198B05A2E7DULL, 0x5A0F544DD2B1FB18ULL, 0x03727073C2E134B1ULL,
+    0xC7F6AA2DE59AEA61ULL, 0x352787BAA0D7C22FULL, 0x9853EAB63B5E0B35ULL, 0xABBDCDD7ED5C0860ULL,
+    0xCF05DAF5AC8D77B0ULL, 0x49CAD48CEBF4A71EULL, 0x7A4C10EC2158C4A6ULL, 0xD9E92AA246BF719EULL,
+    0x13AE978D09FE5557ULL, 0x730499AF921549FFULL, 0x4E4B705B92903BA4ULL, 0xFF577222C14F0A3AULL,
+    0x55B6344CF97AAFAEULL, 0xB862225B055B6960ULL, 0xCAC09AFBDDD2CDB4ULL, 0xDAF8E9829FE96B5FULL,
+    0xB5FDFC5D3132C498ULL, 0x310CB380DB6F7503ULL, 0xE87FBB46217A360EULL, 0x2102AE466EBB1148ULL,
+    0xF8549E1A3AA5E00DULL, 0x07A69AFDCC42261AULL, 0xC4C118BFE78FEAAEULL, 0xF9F4892ED96BD438ULL,
+    0x1AF3DBE25D8F45DAULL, 0xF5B4B0B0D2DEEEB4ULL, 0x962ACEEFA82E1C84ULL, 0x046E3ECAAF453CE9ULL,
+    0xF05D129681949A4CULL, 0x964781CE734B3C84ULL, 0x9C2ED44081CE5FBDULL, 0x522E23F3925E319EULL,
+    0x177E00F9FC32F791ULL, 0x2BC60A63A6F3B3F2ULL, 0x222BBFAE61725606ULL, 0x486289DDCC3D6780ULL,
+    0x7DC7785B8EFDFC80ULL, 0x8AF38731C02BA980ULL, 0x1FAB64EA29A2DDF7ULL, 0xE4D9429322CD065AULL,
+    0x9DA058C67844F20CULL, 0x24C0E332B70019B0ULL, 0x233003B5A6CFE6ADULL, 0xD586BD01C5C217F6ULL,
+    0x5E5637885F29BC2BULL, 0x7EBA726D8C94094BULL, 0x0A56A5F0BFE39272ULL, 0xD79476A84EE20D06ULL,
+    0x9E4C1269BAA4BF37ULL, 0x17EFEE45B0DEE640ULL, 0x1D95B0A5FCF90BC6ULL, 0x93CBE0B699C2585DULL,
+    0x65FA4F227A2B6D79ULL, 0xD5F9E858292504D5ULL, 0xC2B5A03F71471A6FULL, 0x59300222B4561E00ULL,
+    0xCE2F8642CA0712DCULL, 0x7CA9723FBB2E8988ULL, 0x2785338347F2BA08ULL, 0xC61BB3A141E50E8CULL,
+    0x150F361DAB9DEC26ULL, 0x9F6A419D382595F4ULL, 0x64A53DC924FE7AC9ULL, 0x142DE49FFF7A7C3DULL,
+    0x0C335248857FA9E7ULL, 0x0A9C32D5EAE45305ULL, 0xE6C42178C4BBB92EULL, 0x71F1CE2490D20B07ULL,
+    0xF1BCC3D275AFE51AULL, 0xE728E8C83C334074ULL, 0x96FBF83A12884624ULL, 0x81A1549FD6573DA5ULL,
+    0x5FA7867CAF35E149ULL, 0x56986E2EF3ED091BULL, 0x917F1DD5F8886C61ULL, 0xD20D8C88C8FFE65FULL,
+    0x31D71DCE64B2C310ULL, 0xF165B587DF898190ULL, 0xA57E6339DD2CF3A0ULL, 0x1EF6E6DBB1961EC9ULL,
+    0x70CC73D90BC26E24ULL, 0xE21A6B35DF0C3AD7ULL, 0x003A93D8B2806962ULL, 0x1C99DED33CB890A1ULL,
+    0xCF3145DE0ADD4289ULL, 0xD0E4427A5514FB72ULL, 0x77C621CC9FB3A483ULL, 0x67A34DAC4356550BULL,
+    0xF8D626AAAF278509ULL
+};
+
+// Polyglot piece kinds [piece]
+const int polyglot_piece[12] = {
+    [P] = 1, [N] = 3, [B] = 5, [R] = 7, [Q] = 9, [K] = 11,
+    [p] = 0, [n] = 2, [b] = 4, [r] = 6, [q] = 8, [k] = 10};
+
+// Polyglot promotion codes
+const char polyglot_promoted[] = " nbrq";
+
+// book entry as stored in the file
+typedef struct
+{
+  u64 key;
+  unsigned short move;
+  unsigned short weight;
+  unsigned int learn;
+} book_entry;
+
+// memory mapped book
+book_entry *book_entries = NULL;
+
+// number of entries in the book
+long book_count = 0;
+
+// book move selection of the session (0 - weighted random, 1 - highest weight)
+__thread int book_best = 0;
+
+// generate Polyglot hash key of the current position
+u64 polyglot_key()
+{
+  // final hash key
+  u64 final_key = 0ULL;
+
+  // loop over piece bitboards
+  for (int piece = P; piece <= k; piece++)
+  {
+    // init piece bitboard copy
+    u64 bitboard = bitboards[piece];
+
+    // loop over the pieces within a bitboard
+    while (bitboard)
+    {
+      // init square occupied by the piece (Polyglot counts rows from rank 1)
+      int square = get_lsb1st_index(bitboard);
+
+      // hash piece
+      final_key ^= polyglot_random[64 * polyglot_piece[piece] + mirror_square(square)];
+
+      // pop LS1B
+      pop_bit(bitboard, square);
+    }
+  }
+
+  // hash castling rights
+  if (castle & wk)
+    final_key ^= polyglot_random[768];
+  if (castle & wq)
+    final_key ^= polyglot_random[769];
+  if (castle & bk)
+    final_key ^= polyglot_random[770];
+  if (castle & bq)
+    final_key ^= polyglot_random[771];
+
+  // hash en passant file only if a pawn of the side to move can capture on it
+  if (enpassant != no_sq && (pawn_attacks[side ^ 1][enpassant] & bitboards[(side == white) ? P : p]))
+    final_key ^= polyglot_random[772 + (enpassant & 7)];
+
+  // hash the side only if white is to move
+  if (side == white)
+    final_key ^= polyglot_random[780];
+
+  // return generated hash key
+  return final_key;
+}
+
+// close current book
+void close_book()
+{
+  // no book loaded
+  if (book_entries == NULL)
+    return;
+
+#ifdef WIN64
+  free(book_entries);
+#else
+  munmap(book_entries, book_count * sizeof(book_entry));
+#endif
+
+  book_entries = NULL;
+  book_count = 0;
+}
+
+// map book file into memory (returns number of entries)
+long open_book(char *path)
+{
+  // drop previous book
+  close_book();
+
+  // no book requested
+  if (!*path || !strcmp(path, "<empty>"))
+    return 0;
+
+#ifdef WIN64
+  // read the whole book into memory
+  FILE *file = fopen(path, "rb");
+
+  if (file == NULL)
+  {
+    printf("info string unable to open book %s\n", path);
+    return 0;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file) / sizeof(book_entry);
+  fseek(file, 0, SEEK_SET);
+
+  book_entries = malloc(size * sizeof(book_entry));
+
+  if (book_entries != NULL)
+    book_count = fread(book_entries, sizeof(book_entry), size, file);
+
+  fclose(file);
+#else
+  // map the book read-only, the kernel shares the pages between processes
+  int file = open(path, O_RDONLY);
+  struct stat file_stat;
+
+  if (file < 0 || fstat(file, &file_stat) < 0)
+  {
+    printf("info string unable to open book %s\n", path);
+
+    if (file >= 0)
+      close(file);
+
+    return 0;
+  }
+
+  long size = file_stat.st_size / sizeof(book_entry);
+
+  if (size)
+  {
+    void *memory = mmap(NULL, size * sizeof(book_entry), PROT_READ, MAP_PRIVATE, file, 0);
+
+    if (memory != MAP_FAILED)
+    {
+      book_entries = memory;
+      book_count = size;
+    }
+  }
+
+  close(file);
+#endif
+
+  // seed move selection so games do not repeat the same line
+  random_state = get_time_ms() | 1;
+
+  printf("info string book %s loaded with %ld entries\n", path, book_count);
+
+  return book_count;
+}
+
+// extract book entry key
+#define get_book_key(index) __builtin_bswap64(book_entries[index].key)
+
+// convert Polyglot move into engine move (0 if not legal here)
+int book_to_move(int book_move, moves *move_list)
+{
+  // parse source & target squares (Polyglot rows count from rank 1)
+  int target_square = mirror_square(book_move & 0x3f);
+  int source_square = mirror_square((book_move >> 6) & 0x3f);
+
+  // parse promoted piece
+  char promoted = polyglot_promoted[(book_move >> 12) & 7];
+
+  // loop over generated moves
+  for (int count = 0; count < move_list->count; count++)
+  {
+    // init move
+    int move = move_list->moves[count];
+
+    // init target square
+    int target = get_move_target(move);
+
+    // castling is encoded as king takes own rook
+    if (get_move_castle(move))
+      target = (target == g1) ? h1 : (target == c1) ? a1 : (target == g8) ? h8 : a8;
+
+    // match squares and promotion
+    if (get_move_source(move) != source_square || target != target_square)
+      continue;
+
+    if (promoted != ' ' ? promoted_pieces[get_move_promoted(move)] != promoted : get_move_promoted(move) != 0)
+      continue;
+
+    // preserve board state
+    copy_board();
+
+    // make sure the book move is legal
+    int legal = make_move(move, all_moves);
+
+    // restore board state
+    take_back();
+
+    return legal ? move : 0;
+  }
+
+  // move not found
+  return 0;
+}
+
+// probe book for the current position (returns 0 when out of book)
+int probe_book()
+{
+  // no book loaded
+  if (book_count == 0)
+    return 0;
+
+  // init position key
+  u64 key = polyglot_key();
+
+  // binary search the first entry matching the key
+  long low = 0, high = book_count;
+
+  while (low < high)
+  {
+    long middle = (low + high) / 2;
+
+    if (get_book_key(middle) < key)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  // create move list instance
+  moves move_list[1];
+
+  // generate moves
+  generate_moves(move_list);
+
+  // collected book moves
+  int book_moves[256], book_weights[256], book_moves_count = 0, total_weight = 0;
+
+  // loop over entries of this position
+  for (long index = low; index < book_count && get_book_key(index) == key && book_moves_count < 256; index++)
+  {
+    // convert book move
+    int move = book_to_move(__builtin_bswap16(book_entries[index].move), move_list);
+
+    // skip moves not legal in this position
+    if (move == 0)
+      continue;
+
+    // store move & weight
+    book_moves[book_moves_count] = move;
+    book_weights[book_moves_count] = __builtin_bswap16(book_entries[index].weight);
+    total_weight += book_weights[book_moves_count++];
+  }
+
+  // out of book
+  if (book_moves_count == 0)
+    return 0;
+
+  // init selected move index
+  int selected = 0;
+
+  // pick highest weight
+  if (book_best || total_weight == 0)
+  {
+    for (int index = 1; index < book_moves_count; index++)
+      if (book_weights[index] > book_weights[selected])
+        selected = index;
+  }
+
+  // pick proportionally to weights
+  else
+  {
+    int pick = get_random_u32_number() % total_weight;
+
+    while (pick >= book_weights[selected])
+      pick -= book_weights[selected++];
+  }
+
+  // return book move
+  return book_moves[selected];
+}
+
+/*
+ *
+ *                UCI
+ *
+ */
+
+// engine name
+#define version "0.1"
+
+// parse user/GUI move string input (e.g. "e7e8q")
+int parse_move(char *move_string)
+{
+  // create move list instance
+  moves move_list[1];
+
+  // generate moves
+  generate_moves(move_list);
+
+  // parse source square
+  int source_square = (move_string[0] - 'a') + (8 - (move_string[1] - '0')) * 8;
+
+  // parse target square
+  int target_square = (move_string[2] - 'a') + (8 - (move_string[3] - '0')) * 8;
+
+  // loop over the moves within a move list
+  for (int move_count = 0; move_count < move_list->count; move_count++)
+  {
+    // init move
+    int move = move_list->moves[move_count];
+
+    // make sure source & target squares are available within the generated move
+    if (source_square == get_move_source(move) && target_square == get_move_target(move))
+    {
+      // init promoted piece
+      int promoted_piece = get_move_promoted(move);
+
+      // promoted piece is available
+      if (promoted_piece)
+      {
+        // the promoted piece has to match the requested one
+        if (promoted_pieces[promoted_piece] == move_string[4])
+          return move;
+
+        // continue the loop on possible wrong promotions (e.g. "e7e8f")
+        continue;
+      }
+
+      // return legal move
+      return move;
+    }
+  }
+
+  // return illegal move
+  return 0;
+}
+
+/*
+    Example UCI commands to init position on chess board
+
+    // init start position
+    position startpos
+
+    // init start position and make the moves on chess board
+    position startpos moves e2e4 e7e5
+
+    // init position from FEN string
+    position fen r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1
+
+    // init position from fen string and make moves on chess board
+    position fen r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1 moves e2a6 e8g8
+*/
+
+// parse UCI "position" command
+void parse_position(char *command)
+{
+  // shift pointer to the right where next token begins
+  command += 9;
+
+  // init pointer to the current character in the command string
+  char *current_char = command;
+
+  // parse UCI "startpos" command
+  if (strncmp(command, "startpos", 8) == 0)
+    // init chess board with start position
+    parse_fen(start_position);
+
+  // parse UCI "fen" command
+  else
+  {
+    // make sure "fen" command is available within command string
+    current_char = strstr(command, "fen");
+
+    // if no "fen" command is available within command string
+    if (current_char == NULL)
+      // init chess board with start position
+      parse_fen(start_position);
+
+    // found "fen" substring
+    else
+    {
+      // shift pointer to the right where next token begins
+      current_char += 4;
+
+      // init chess board with position from FEN string (the start position if it can't be searched)
+      if (!parse_fen(current_char))
+      {
+        fprintf(client->output, "info string invalid fen, using the start position\n");
+        parse_fen(start_position);
+        return;
+      }
+    }
+  }
+
+  // parse moves after position
+  current_char = strstr(command, "moves");
+
+  // moves available
+  if (current_char != NULL)
+  {
+    // shift pointer to the right where next token begins
+    current_char += 6;
+
+    // loop over moves within a move string
+    while (*current_char)
+    {
+      // parse next move
+      int move = parse_move(current_char);
+
+      // if no more moves
+      if (move == 0)
+        // break out of the loop
+        break;
+
+      // preserve board state
+      copy_board();
+
+      // very long reversible sequences forget their oldest position, leaving room for the search plies
+      if (repetition_index == max_repetitions - max_ply)
+        memmove(repetition_table, repetition_table + 1, --repetition_index * sizeof(u64));
+
+      // store the position before the move for repetition detection
+      repetition_table[repetition_index++] = hash_key;
+
+      // make move on the chess board (stop at illegal moves)
+      if (make_move(move, all_moves) == 0)
+      {
+        repetition_index--;
+        take_back();
+        break;
+      }
+
+      // positions before a capture or pawn move can't come back
+      if (fifty == 0)
+        repetition_index = 0;
+
+      // move current character pointer to the end of current move
+      while (*current_char && *current_char != ' ')
+        current_char++;
+
+      // go to the next move
+      while (*current_char == ' ')
+        current_char++;
+    }
+  }
+}
+
+// board state handed over between threads
+typedef struct
+{
+  u64 bitboards[12];
+  u64 occupancies[3];
+  int side, enpassant, castle, fifty;
+  u64 hash_key, pawn_key;
+  u64 repetition_table[max_repetitions];
+  int repetition_index;
+} position_state;
+
+// store current thread's board state
+void save_position(position_state *position)
+{
+  memcpy(position->bitboards, bitboards, sizeof(bitboards));
+  memcpy(position->occupancies, occupancies, sizeof(occupancies));
+  position->side = side;
+  position->enpassant = enpassant;
+  position->castle = castle;
+  position->fifty = fifty;
+  position->hash_key = hash_key;
+  position->pawn_key = pawn_key;
+  memcpy(position->repetition_table, repetition_table, sizeof(repetition_table));
+  position->repetition_index = repetition_index;
+}
+
+// load board state into current thread
+void restore_position(position_state *position)
+{
+  memcpy(bitboards, position->bitboards, sizeof(bitboards));
+  memcpy(occupancies, position->occupancies, sizeof(occupancies));
+  side = position->side;
+  enpassant = position->enpassant;
+  castle = position->castle;
+  fifty = position->fifty;
+  hash_key = position->hash_key;
+  pawn_key = position->pawn_key;
+  memcpy(repetition_table, position->repetition_table, sizeof(repetition_table));
+  repetition_index = position->repetition_index;
+}
+
+// search parameters handed from the UCI thread to the search thread
+typedef struct
+{
+  position_state position;
+  int depth;
+  int timeset;
+  int stoptime;
+  int time_budget;
+  long nodes_limit;
+  int pondering;
+  int mate;
+
+  // session the search reports to, its options and private hash table
+  uci_client *client;
+  int multi_pv, use_iir, use_probcut;
+  int eval_cache_size, mate_hash_size;
+  tt *hash_table;
+  u64 hash_entries;
+} search_request;
+
+// current search request of the session
+__thread search_request uci_request;
+
+// search thread handle of the session
+__thread pthread_t search_thread;
+
+// search thread started and not joined yet
+__thread int search_running = 0;
+
+// hash table file saved on exit and loaded by "setoption name HashFile"
+char hash_file[4096];
+
+// search thread entry point
+void *search_worker(void *argument)
+{
+  // init request
+  search_request *request = argument;
+
+  // take over position & limits
+  restore_position(&request->position);
+  timeset = request->timeset;
+  stoptime = request->stoptime;
+  time_budget = request->time_budget;
+  nodes_limit = request->nodes_limit;
+  pondering = request->pondering;
+
+  // take over session
+  client = request->client;
+  multi_pv = request->multi_pv;
+  use_iir = request->use_iir;
+  use_probcut = request->use_probcut;
+  eval_cache_size = request->eval_cache_size;
+  mate_hash_size = request->mate_hash_size;
+  private_hash_table = request->hash_table;
+  private_hash_entries = request->hash_entries;
+
+  // prove a mate or search position (prints info & bestmove)
+  if (request->mate)
+    mate_search(request->mate);
+  else
+    search_position(request->depth);
+
+  free_eval_cache();
+  free_mate_table();
+
+  return NULL;
+}
+
+// stop running search and wait for its bestmove
+void stop_search()
+{
+  // no search started
+  if (!search_running)
+    return;
+
+  // interrupt search
+  client->stop = 1;
+  client->ponder = 0;
+
+  // wait for the search thread to print bestmove
+  pthread_join(search_thread, NULL);
+
+  // reset flags
+  search_running = 0;
+  client->stop = 0;
+}
+
+/*
+    Example UCI commands to make engine search for the best move
+
+    // fixed depth search
+    go depth 64
+
+    // search for a fixed number of nodes
+    go nodes 100000
+
+    // search for a fixed time
+    go movetime 1000
+
+    // clock based search
+    go wtime 60000 btime 60000 winc 1000 binc 1000 movestogo 40
+
+    // search on the opponent's time until "ponderhit" or "stop"
+    go ponder wtime 60000 btime 60000
+
+    // search until "stop"
+    go infinite
+
+    // prove the shortest mate in up to 5 moves
+    go mate 5
+*/
+
+// parse UCI "go" command
+void parse_go(char *command)
+{
+  // finish previous search
+  stop_search();
+
+  // init parameters
+  int depth = -1, time = -1, inc = 0, movestogo = 30, movetime = -1;
+
+  // init argument
+  char *argument = NULL;
+
+  // match UCI "binc" command
+  if ((argument = strstr(command, "binc")) && side == black)
+    // parse black time increment
+    inc = atoi(argument + 5);
+
+  // match UCI "winc" command
+  if ((argument = strstr(command, "winc")) && side == white)
+    // parse white time increment
+    inc = atoi(argument + 5);
+
+  // match UCI "wtime" command
+  if ((argument = strstr(command, "wtime")) && side == white)
+    // parse white time limit
+    time = atoi(argument + 6);
+
+  // match UCI "btime" command
+  if ((argument = strstr(command, "btime")) && side == black)
+    // parse black time limit
+    time = atoi(argument + 6);
+
+  // match UCI "movestogo" command
+  if ((argument = strstr(command, "movestogo")))
+    // parse number of moves to go
+    movestogo = atoi(argument + 10);
+
+  // match UCI "movetime" command
+  if ((argument = strstr(command, "movetime")))
+    // parse amount of time allowed to spend to make a move
+    movetime = atoi(argument + 9);
+
+  // match UCI "depth" command
+  if ((argument = strstr(command, "depth")))
+    // parse search depth
+    depth = atoi(argument + 6);
+
+  // match UCI "nodes" command
+  long node_limit = (argument = strstr(command, "nodes")) ? atol(argument + 6) : 0;
+
+  // match UCI "mate" command
+  int mate = (argument = strstr(command, "mate")) ? atoi(argument + 5) : 0;
+
+  // match UCI "ponder" & "infinite" commands
+  int ponder = strstr(command, "ponder") != NULL;
+  int infinite = strstr(command, "infinite") != NULL;
+
+  // if move time is available
+  if (movetime != -1)
+  {
+    // set time equal to move time
+    time = movetime;
+
+    // set moves to go to 1
+    movestogo = 1;
+    inc = 0;
+  }
+
+  // init start time
+  int starttime = get_time_ms();
+
+  // if time control is available
+  uci_request.timeset = 0;
+
+  if (time != -1 && !infinite)
+  {
+    // flag we're playing with time control
+    uci_request.timeset = 1;
+
+    // set up timing (keep a safety margin for the GUI)
+    time /= (movestogo > 0) ? movestogo : 1;
+    time -= 50;
+
+    if (time < 0)
+      time = 0;
+
+    // init time budget and stoptime
+    uci_request.time_budget = time + inc;
+    uci_request.stoptime = starttime + time + inc;
+  }
+
+  // if depth is not available
+  if (depth == -1 || depth > max_ply - 1)
+    // set depth to the max ply
+    depth = max_ply - 1;
+
+  // play from the opening book while the position is covered
+  int move = (ponder || infinite || mate) ? 0 : probe_book();
+
+  if (move)
+  {
+    char move_string[6];
+    fprintf(client->output, "bestmove %s\n", move_to_uci(move, move_string));
+    return;
+  }
+
+  // init search request
+  save_position(&uci_request.position);
+  uci_request.depth = depth;
+  uci_request.nodes_limit = node_limit;
+  uci_request.pondering = ponder || infinite;
+  uci_request.mate = mate;
+
+  // search on behalf of this session
+  uci_request.client = client;
+  uci_request.multi_pv = multi_pv;
+  uci_request.use_iir = use_iir;
+  uci_request.use_probcut = use_probcut;
+  uci_request.eval_cache_size = eval_cache_size;
+  uci_request.mate_hash_size = mate_hash_size;
+  uci_request.hash_table = private_hash_table;
+  uci_request.hash_entries = private_hash_entries;
+
+  // keep searching until "ponderhit" / "stop"
+  client->ponder = ponder || infinite;
+
+  // search position on a separate thread so the UCI loop keeps reading commands
+  search_running = pthread_create(&search_thread, NULL, search_worker, &uci_request) == 0;
+}
+
+// UCI loop
+void uci_loop(FILE *commands)
+{
+  // define user / GUI input buffer
+  char input[10000];
+
+  // sessions of the analysis server leave the process wide tables alone
+  int server_session = client != &console_client;
+
+  // private hash table size of a server session ("SharedHash" off)
+  int private_hash_mb = default_hash_size;
+
+  // init start position
+  parse_fen(start_position);
+
+  // main loop
+  while (1)
+  {
+    // reset user /GUI input
+    memset(input, 0, sizeof(input));
+
+    // make sure output reaches the GUI
+    fflush(client->output);
+
+    // get user / GUI input (quit on end of input)
+    if (!fgets(input, sizeof(input), commands))
+    {
+      // let a limited search finish when input is piped in
+      if (search_running && !client->ponder)
+      {
+        pthread_join(search_thread, NULL);
+        search_running = 0;
+      }
+
+      break;
+    }
+
+    // make sure input is available
+    if (input[0] == '\n')
+      continue;
+
+    // strip the line terminator
+    input[strcspn(input, "\r\n")] = '\0';
+
+    // parse UCI "isready" command
+    if (strncmp(input, "isready", 7) == 0)
+    {
+      fprintf(client->output, "readyok\n");
+      continue;
+    }
+
+    // parse UCI "position" command
+    else if (strncmp(input, "position", 8) == 0)
+    {
+      // call parse position function
+      stop_search();
+      parse_position(input);
+    }
+
+    // parse UCI "ucinewgame" command
+    else if (strncmp(input, "ucinewgame", 10) == 0)
+    {
+      // init start position and forget the previous game
+      stop_search();
+      parse_fen(start_position);
+
+      // the shared table of the server (or of the shared memory segment) belongs to all sessions
+      if (private_hash_table != NULL)
+        memset(private_hash_table, 0, private_hash_entries * sizeof(tt));
+      else if (!server_session && hash_segment_fd < 0)
+        clear_hash_table();
+    }
+
+    // parse UCI "go" command
+    else if (strncmp(input, "go", 2) == 0)
+      // call parse go function
+      parse_go(input);
+
+    // parse UCI "ponderhit" command (keep searching, the clock starts now)
+    else if (strncmp(input, "ponderhit", 9) == 0)
+      client->ponder = 0;
+
+    // parse UCI "stop" command
+    else if (strncmp(input, "stop", 4) == 0)
+      stop_search();
+
+    // commands reloading process wide tables are left to the console
+    else if (server_session && (strncmp(input, "savehash", 8) == 0 || strncmp(input, "bench", 5) == 0 ||
+                                strncmp(input, "setoption name HashFile", 23) == 0 ||
+                                strncmp(input, "setoption name HashSegment", 26) == 0 ||
+                                strncmp(input, "setoption name SyzygyPath", 25) == 0 ||
+                                strncmp(input, "setoption name BookFile", 23) == 0))
+      fprintf(client->output, "info string \"%s\" is not available in server sessions\n", input);
+
+    // save hash table ("savehash [file]", defaults to the HashFile option)
+    else if (strncmp(input, "savehash", 8) == 0)
+    {
+      stop_search();
+
+      if (input[8] == ' ' || *hash_file)
+        save_hash_table(input[8] == ' ' ? input + 9 : hash_file);
+    }
+
+    // search benchmark under the current options ("bench [depth]"), e.g. to compare node counts with IIR or ProbCut off
+    else if (strncmp(input, "bench", 5) == 0)
+    {
+      stop_search();
+
+      // bench runs on its own private hash table, keep the configured one
+      int mb = hash_entries * sizeof(tt) / 0x100000;
+
+      char segment[sizeof(hash_segment)];
+      strcpy(segment, hash_segment);
+      *hash_segment = 0;
+
+      search_bench(input[5] == ' ' ? atoi(input + 6) : bench_depth);
+
+      strcpy(hash_segment, segment);
+      init_hash_table(mb);
+    }
+
+    // parse UCI "quit" command
+    else if (strncmp(input, "quit", 4) == 0)
+      // quit from the chess engine program execution
+      break;
+
+    // parse UCI "uci" command
+    else if (strncmp(input, "uci", 3) == 0)
+    {
+      // print engine info
+      fprintf(client->output, "id name Esabella %s\n", version);
+      fprintf(client->output, "id author Arpit-Raj1\n");
+      fprintf(client->output, "option name Hash type spin default %d min 1 max 65536\n", default_hash_size);
+      fprintf(client->output, "option name Ponder type check default false\n");
+      fprintf(client->output, "option name MultiPV type spin default 1 min 1 max %d\n", max_multi_pv);
+      fprintf(client->output, "option name SyzygyPath type string default <empty>\n");
+      fprintf(client->output, "option name BookFile type string default <empty>\n");
+      fprintf(client->output, "option name BookBestMove type check default false\n");
+      fprintf(client->output, "option name IIR type check default true\n");
+      fprintf(client->output, "option name ProbCut type check default true\n");
+      fprintf(client->output, "option name HashFile type string default <empty>\n");
+      fprintf(client->output, "option name HashSegment type string default <empty>\n");
+      fprintf(client->output, "option name EvalCache type spin default %d min 0 max 1024\n", default_eval_cache_size);
+      fprintf(client->output, "option name MateHash type spin default %d min 1 max 65536\n", default_mate_hash_size);
+
+      if (server_session)
+        fprintf(client->output, "option name SharedHash type check default true\n");
+      fprintf(client->output, "uciok\n");
+    }
+
+    // parse UCI "setoption" command
+    else if (strncmp(input, "setoption name ", 15) == 0)
+    {
+      char *value = strstr(input, " value ");
+
+      // options are never changed under a running search
+      stop_search();
+
+      // init hash table size
+      if (strncmp(input + 15, "Hash value ", 11) == 0)
+      {
+        int mb = atoi(value + 7);
+
+        // adjust MB if going beyond the allowed bounds
+        if (mb < 1)
+          mb = 1;
+        if (mb > 65536)
+          mb = 65536;
+
+        // server sessions size their private table, the shared one is sized on the command line
+        if (server_session)
+        {
+          private_hash_mb = mb;
+
+          if (private_hash_table != NULL)
+            init_private_hash_table(mb);
+        }
+        else
+          init_hash_table(mb);
+      }
+
+      // server session searching with a private hash table
+      else if (strncmp(input + 15, "SharedHash", 10) == 0 && value && server_session)
+        init_private_hash_table(strncmp(value + 7, "true", 4) ? private_hash_mb : 0);
+
+      // eval cache size of every search thread
+      else if (strncmp(input + 15, "EvalCache", 9) == 0 && value)
+      {
+        eval_cache_size = atoi(value + 7);
+
+        // adjust MB if going beyond the allowed bounds
+        if (eval_cache_size < 0)
+          eval_cache_size = 0;
+        if (eval_cache_size > 1024)
+          eval_cache_size = 1024;
+      }
+
+      // mate search node table size (allocated by the next "go mate")
+      else if (strncmp(input + 15, "MateHash", 8) == 0 && value)
+      {
+        mate_hash_size = atoi(value + 7);
+
+        // adjust MB if going beyond the allowed bounds
+        if (mate_hash_size < 1)
+          mate_hash_size = 1;
+        if (mate_hash_size > 65536)
+          mate_hash_size = 65536;
+      }
+
+      // number of lines to report
+      else if (strncmp(input + 15, "MultiPV", 7) == 0 && value)
+      {
+        multi_pv = atoi(value + 7);
+
+        // adjust lines if going beyond the allowed bounds
+        if (multi_pv < 1)
+          multi_pv = 1;
+        if (multi_pv > max_multi_pv)
+          multi_pv = max_multi_pv;
+      }
+
+      // hash table in a shared memory segment, shared with the other engine processes on this host
+      else if (strncmp(input + 15, "HashSegment", 11) == 0 && value)
+      {
+        char *name = value + 7;
+
+        // POSIX shared memory names start with a slash
+        if (strcmp(name, "<empty>") && *name)
+          snprintf(hash_segment, sizeof(hash_segment), "%s%s", *name == '/' ? "" : "/", name);
+        else
+          *hash_segment = 0;
+
+        // move the hash table there (or back to private memory), keeping its size
+        init_hash_table(hash_entries * sizeof(tt) / 0x100000);
+      }
+
+      // hash file kept across sessions
+      else if (strncmp(input + 15, "HashFile", 8) == 0 && value)
+      {
+        // remember file to save the hash table to on exit
+        strncpy(hash_file, strcmp(value + 7, "<empty>") ? value + 7 : "", sizeof(hash_file) - 1);
+
+        // continue from the last session
+        if (*hash_file)
+          load_hash_table(hash_file);
+      }
+
+      // load tablebases
+      else if (strncmp(input + 15, "SyzygyPath", 10) == 0 && value)
+        init_syzygy(value + 7);
+
+      // load opening book
+      else if (strncmp(input + 15, "BookFile", 8) == 0 && value)
+        open_book(value + 7);
+
+      // book move selection
+      else if (strncmp(input + 15, "BookBestMove", 12) == 0 && value)
+        book_best = !strncmp(value + 7, "true", 4);
+
+      // internal iterative reduction
+      else if (strncmp(input + 15, "IIR", 3) == 0 && value)
+        use_iir = !strncmp(value + 7, "true", 4);
+
+      // ProbCut
+      else if (strncmp(input + 15, "ProbCut", 7) == 0 && value)
+        use_probcut = !strncmp(value + 7, "true", 4);
+    }
+  }
+
+  // let the search print its bestmove before exiting
+  stop_search();
+
+  // keep the hash table for the next session
+  if (*hash_file && !server_session)
+    save_hash_table(hash_file);
+}
+
+/*
+ *
+ *            Analysis Server
+ *
+ *    esabella server <socket path | port> [hash MB] [sessions N] [syzygy PATH] [book FILE]
+ *
+ *  Listens on a Unix domain socket, or on a localhost TCP port when the
+ *  address is a number, and serves every connection as an independent UCI
+ *  session on its own thread: own position, options and search thread, with
+ *  the "info" and "bestmove" lines streamed back as the search prints them.
+ *  The tables are set up once for all sessions: attack tables, opening book
+ *  and tablebases (loaded from the command line) are shared, so is the
+ *  transposition table unless a session
+ *  asks for its own ("setoption name SharedHash value false", sized by
+ *  "Hash"). Commands reloading process wide tables are refused within
+ *  sessions. "quit" or closing the connection ends a session, the server
+ *  runs until it is killed.
+ *
+ *    printf "position startpos\ngo depth 12\n" | nc -NU /tmp/esabella.sock
+ *
+ */
+
+#ifndef WIN64
+
+// default max number of sessions served at once
+#define default_server_sessions 64
+
+// max number of sessions served at once & number of sessions being served
+int server_sessions_limit = default_server_sessions;
+int server_sessions = 0;
+
+// session thread entry point: serve one connection
+static void *server_session(void *argument)
+{
+  int socket_fd = (int)(long)argument;
+
+  // the session answers on its own connection
+  uci_client session;
+  memset(&session, 0, sizeof(session));
+
+  FILE *commands = fdopen(socket_fd, "r");
+  session.output = fdopen(dup(socket_fd), "w");
+
+  if (commands != NULL && session.output != NULL)
+  {
+    // stream responses a line at a time
+    setvbuf(session.output, NULL, _IOLBF, 0);
+
+    client = &session;
+
+    // own book line choices (sessions starting within the same millisecond differ by their socket)
+    random_state = (get_time_ms() + socket_fd * 0x9e3779b9U) | 1;
+
+    uci_loop(commands);
+  }
+
+  // release the private hash table of the session
+  init_private_hash_table(0);
+
+  if (session.output != NULL)
+    fclose(session.output);
+
+  if (commands != NULL)
+    fclose(commands);
+  else
+    close(socket_fd);
+
+  __sync_fetch_and_sub(&server_sessions, 1);
+
+  return NULL;
+}
+
+// open the listening socket (returns -1 on failure)
+static int server_listen(char *address)
+{
+  int listen_fd;
+
+  // TCP port on the loopback interface
+  if (strspn(address, "0123456789") == strlen(address))
+  {
+    struct sockaddr_in socket_address;
+    memset(&socket_address, 0, sizeof(socket_address));
+
+    socket_address.sin_family = AF_INET;
+    socket_address.sin_port = htons(atoi(address));
+    socket_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (listen_fd < 0)
+      return -1;
+
+    // restart without waiting for connections of the previous server to time out
+    int reuse = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    if (bind(listen_fd, (struct sockaddr *)&socket_address, sizeof(socket_address)) < 0)
+    {
+      close(listen_fd);
+      return -1;
+    }
+  }
+
+  // Unix domain socket
+  else
+  {
+    struct sockaddr_un socket_address;
+    memset(&socket_address, 0, sizeof(socket_address));
+
+    if (strlen(address) >= sizeof(socket_address.sun_path))
+      return -1;
+
+    socket_address.sun_family = AF_UNIX;
+    strcpy(socket_address.sun_path, address);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (listen_fd < 0)
+      return -1;
+
+    // a socket file nobody listens on is left over from a server that didn't exit cleanly
+    struct stat file_status;
+
+    if (stat(address, &file_status) == 0 && S_ISSOCK(file_status.st_mode) &&
+        connect(listen_fd, (struct sockaddr *)&socket_address, sizeof(socket_address)) < 0)
+      unlink(address);
+
+    if (bind(listen_fd, (struct sockaddr *)&socket_address, sizeof(socket_address)) < 0)
+    {
+      close(listen_fd);
+      return -1;
+    }
+  }
+
+  if (listen(listen_fd, 16) < 0)
+  {
+    close(listen_fd);
+    return -1;
+  }
+
+  return listen_fd;
+}
+
+// analysis server: accept connections until the process is killed
+int analysis_server(int argc, char *argv[])
+{
+  int hash_size = default_hash_size;
+  char *syzygy_path = NULL, *book_path = NULL;
+
+  // parse options
+  for (int index = 1; index + 1 < argc; index += 2)
+  {
+    if (!strcmp(argv[index], "hash"))
+      hash_size = atoi(argv[index + 1]);
+
+    else if (!strcmp(argv[index], "sessions"))
+      server_sessions_limit = atoi(argv[index + 1]);
+
+    else if (!strcmp(argv[index], "syzygy"))
+      syzygy_path = argv[index + 1];
+
+    else if (!strcmp(argv[index], "book"))
+      book_path = argv[index + 1];
+
+    else
+    {
+      fprintf(stderr, "server: unknown option %s\n", argv[index]);
+      return 1;
+    }
+  }
+
+  // the shared hash table is sized once for all sessions
+  if (hash_size != default_hash_size && hash_size > 0)
+    init_hash_table(hash_size);
+
+  // tablebases and book are loaded once, sessions can't reload them
+  if (syzygy_path)
+    init_syzygy(syzygy_path);
+
+  if (book_path && !open_book(book_path))
+  {
+    fprintf(stderr, "server: can't load book %s\n", book_path);
+    return 1;
+  }
+
+  int listen_fd = server_listen(argv[0]);
+
+  if (listen_fd < 0)
+  {
+    fprintf(stderr, "server: can't listen on %s\n", argv[0]);
+    return 1;
+  }
+
+  // a client closing its connection must not take the server down
+  signal(SIGPIPE, SIG_IGN);
+
+  // server log lines reach a redirected log right away
+  setvbuf(stdout, NULL, _IOLBF, 0);
+
+  printf("info string listening on %s\n", argv[0]);
+  fflush(stdout);
+
+  while (1)
+  {
+    int socket_fd = accept(listen_fd, NULL, NULL);
+
+    if (socket_fd < 0)
+    {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+
+      break;
+    }
+
+    // turn clients away beyond the session limit
+    if (__sync_fetch_and_add(&server_sessions, 1) >= server_sessions_limit)
+    {
+      dprintf(socket_fd, "info string server busy\n");
+      close(socket_fd);
+      __sync_fetch_and_sub(&server_sessions, 1);
+      continue;
+    }
+
+    // one thread per session
+    pthread_t session_thread;
+
+    if (pthread_create(&session_thread, NULL, server_session, (void *)(long)socket_fd) != 0)
+    {
+      close(socket_fd);
+      __sync_fetch_and_sub(&server_sessions, 1);
+      continue;
+    }
+
+    pthread_detach(session_thread);
+  }
+
+  fprintf(stderr, "server: accept failed\n");
+  close(listen_fd);
+
+  return 1;
+}
+
+#else
+
+// analysis server (not available on Windows)
+int analysis_server(int argc, char *argv[])
+{
+  fprintf(stderr, "server: not supported on this platform\n");
+  return 1;
+}
+
+#endif
+
+/*
+ *
+ *            Main Driver
+ *
+ */
+
+// init all
+void init_all()
+{
+#ifndef WIN64
+  // clear the hash table with one thread per CPU
+  hash_clear_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+  if (hash_clear_threads < 1)
+    hash_clear_threads = 1;
+  if (hash_clear_threads > max_clear_threads)
+    hash_clear_threads = max_clear_threads;
+#endif
+
+  init_leapers_attacks();
+
+  init_sliders_attacks(bishop);
+  init_sliders_attacks(rook);
+
+  init_random_keys();
+
+  init_batch_tables();
+
+  init_hash_table(default_hash_size);
+}
+
+// perft driver
+static inline void perft_driver(int depth)
+{
+  // recursion escape condition
+  if (depth == 0)
+  {
+    nodes++;
+    return;
+  }
+
+  // move list of this ply
+  moves *move_list = &search_stack[ply].move_list;
+  generate_moves(move_list);
+
+  for (int move_count = 0; move_count < move_list->count; move_count++)
+  {
+    // preserve board state
+    copy_board();
+
+    // make move
+    if (!make_move(move_list->moves[move_count], all_moves))
+    {
+      take_back();
+      continue;
+    }
+
+    // call perft driver recursively
+    ply++;
+    perft_driver(depth - 1);
+    ply--;
+
+    take_back();
+  }
+}
+
+// perft test
+void perft_test(int depth)
+{
+  printf("\n     Performance Test: \n");
+
+  reset_stats();
+
+  moves move_list[1];
+  generate_moves(move_list);
+  long start = get_time_ms();
+
+  for (int move_count = 0; move_count < move_list->count; move_count++)
+  {
+    // preserve board state
+    copy_board();
+
+    // make move
+    if (!make_move(move_list->moves[move_count], all_moves))
+    {
+      take_back();
+      continue;
+    }
+
+    // cummulative nodes
+    long cummulative_nodes = nodes;
+    // call perft driver recursively
+    ply++;
+    perft_driver(depth - 1);
+    ply--;
+
+    long old_nodes = nodes - cummulative_nodes;
+
+    take_back();
+    printf("     %s %s %c   Nodes: %ld\n", square_to_coordinates[get_move_source(move_list->moves[move_count])], square_to_coordinates[get_move_target(move_list->moves[move_count])], promoted_pieces[get_move_promoted(move_list->moves[move_count])], old_nodes);
+  }
+
+  long time = get_time_ms() - start;
+
+  printf("\n     Depth: %d\n", depth);
+  printf("     Nodes: %ld\n", nodes);
+  printf("     Time: %ld\n", time);
+  printf("     NPS: %ld\n\n", time ? nodes * 1000 / time : 0);
+
+  print_stats();
+}
+
+// perft regression suite entry
+typedef struct
+{
+  char *fen;  // position
+  int depth;  // perft depth
+  long nodes; // known leaf node count
+} perft_entry;
+
+/*
+ * Perft regression suite: castling rights, minor and major piece
+ * endings, pawn races, promotions and the classic debug positions,
+ * most of them in both colour mirrored versions
+ */
+const perft_entry perft_suite[] = {
+    {start_position, 5, 4865609},
+    {"r3k2r/8/8/8/8/8/8/R3K2R w KQkq -", 4, 314346},
+    {"4k3/8/8/8/8/8/8/4K2R w K -", 6, 764643},
+    {"4k3/8/8/8/8/8/8/R3K3 w Q -", 6, 846648},
+    {"4k2r/8/8/8/8/8/8/4K3 w k -", 6, 899442},
+    {"r3k3/8/8/8/8/8/8/4K3 w q -", 6, 1001523},
+    {"4k3/8/8/8/8/8/8/R3K2R w KQ -", 5, 532933},
+    {"r3k2r/8/8/8/8/8/8/4K3 w kq -", 5, 118882},
+    {"8/8/8/8/8/8/6k1/4K2R w K -", 6, 185867},
+    {"8/8/8/8/8/8/1k6/R3K3 w Q -", 6, 413018},
+    {"4k2r/6K1/8/8/8/8/8/8 w k -", 6, 179869},
+    {"r3k3/1K6/8/8/8/8/8/8 w q -", 6, 367724},
+    {"r3k2r/8/8/8/8/8/8/1R2K2R w Kkq -", 4, 328965},
+    {"r3k2r/8/8/8/8/8/8/2R1K2R w Kkq -", 4, 312835},
+    {"r3k2r/8/8/8/8/8/8/R3K1R1 w Qkq -", 4, 316214},
+    {"1r2k2r/8/8/8/8/8/8/R3K2R w KQk -", 4, 334705},
+    {"2r1k2r/8/8/8/8/8/8/R3K2R w KQk -", 4, 317324},
+    {"r3k1r1/8/8/8/8/8/8/R3K2R w KQq -", 4, 320792},
+    {"4k3/8/8/8/8/8/8/4K2R b K -", 6, 899442},
+    {"4k3/8/8/8/8/8/8/R3K3 b Q -", 6, 1001523},
+    {"4k2r/8/8/8/8/8/8/4K3 b k -", 6, 764643},
+    {"r3k3/8/8/8/8/8/8/4K3 b q -", 6, 846648},
+    {"4k3/8/8/8/8/8/8/R3K2R b KQ -", 5, 118882},
+    {"r3k2r/8/8/8/8/8/8/4K3 b kq -", 5, 532933},
+    {"8/8/8/8/8/8/6k1/4K2R b K -", 6, 179869},
+    {"8/8/8/8/8/8/1k6/R3K3 b Q -", 6, 367724},
+    {"4k2r/6K1/8/8/8/8/8/8 b k -", 6, 185867},
+    {"r3k3/1K6/8/8/8/8/8/8 b q -", 6, 413018},
+    {"r3k2r/8/8/8/8/8/8/R3K2R b KQkq -", 4, 314346},
+    {"r3k2r/8/8/8/8/8/8/1R2K2R b Kkq -", 4, 334705},
+    {"r3k2r/8/8/8/8/8/8/2R1K2R b Kkq -", 4, 317324},
+    {"r3k2r/8/8/8/8/8/8/R3K1R1 b Qkq -", 4, 320792},
+    {"1r2k2r/8/8/8/8/8/8/R3K2R b KQk -", 4, 328965},
+    {"2r1k2r/8/8/8/8/8/8/R3K2R b KQk -", 4, 312835},
+    {"r3k1r1/8/8/8/8/8/8/R3K2R b KQq -", 4, 316214},
+    {"8/1n4N1/2k5/8/8/5K2/1N4n1/8 w - -", 5, 570726},
+    {"8/1k6/8/5N2/8/4n3/8/2K5 w - -", 5, 223507},
+    {"8/8/4k3/3Nn3/3nN3/4K3/8/8 w - -", 5, 1198299},
+    {"K7/8/2n5/1n6/8/8/8/k6N w - -", 6, 588695},
+    {"k7/8/2N5/1N6/8/8/8/K6n w - -", 6, 688780},
+    {"8/1n4N1/2k5/8/8/5K2/1N4n1/8 b - -", 5, 582642},
+    {"8/1k6/8/5N2/8/4n3/8/2K5 b - -", 5, 288141},
+    {"8/8/3K4/3Nn3/3nN3/4k3/8/8 b - -", 5, 281190},
+    {"K7/8/2n5/1n6/8/8/8/k6N b - -", 6, 688780},
+    {"k7/8/2N5/1N6/8/8/8/K6n b - -", 6, 588695},
+    {"B6b/8/8/8/2K5/4k3/8/b6B w - -", 5, 1320507},
+    {"8/8/1B6/7b/7k/8/2B1b3/7K w - -", 5, 1713368},
+    {"k7/B7/1B6/1B6/8/8/8/K6b w - -", 5, 787524},
+    {"K7/b7/1b6/1b6/8/8/8/k6B w - -", 5, 310862},
+    {"B6b/8/8/8/2K5/5k2/8/b6B b - -", 5, 530585},
+    {"8/8/1B6/7b/7k/8/2B1b3/7K b - -", 5, 1591064},
+    {"k7/B7/1B6/1B6/8/8/8/K6b b - -", 5, 310862},
+    {"K7/b7/1b6/1b6/8/8/8/k6B b - -", 5, 787524},
+    {"7k/RR6/8/8/8/8/rr6/7K w - -", 5, 2161211},
+    {"R6r/8/8/2K5/5k2/8/8/r6R w - -", 4, 771461},
+    {"7k/RR6/8/8/8/8/rr6/7K b - -", 5, 2161211},
+    {"R6r/8/8/2K5/5k2/8/8/r6R b - -", 4, 771368},
+    {"6kq/8/8/8/8/8/8/7K w - -", 6, 391507},
+    {"6KQ/8/8/8/8/8/8/7k b - -", 6, 391507},
+    {"K7/8/8/3Q4/4q3/8/8/7k w - -", 5, 166741},
+    {"6qk/8/8/8/8/8/8/7K b - -", 6, 419369},
+    {"6kq/8/8/8/8/8/8/7K b - -", 6, 363397},
+    {"K7/8/8/3Q4/4q3/8/8/7k b - -", 5, 166741},
+    {"8/8/8/8/8/K7/P7/k7 w - -", 6, 6249},
+    {"8/8/8/8/8/7K/7P/7k w - -", 6, 6249},
+    {"K7/p7/k7/8/8/8/8/8 w - -", 6, 2343},
+    {"7K/7p/7k/8/8/8/8/8 w - -", 6, 2343},
+    {"8/2k1p3/3pP3/3P2K1/8/8/8/8 w - -", 6, 34834},
+    {"8/8/8/8/8/K7/P7/k7 b - -", 6, 2343},
+    {"8/8/8/8/8/7K/7P/7k b - -", 6, 2343},
+    {"K7/p7/k7/8/8/8/8/8 b - -", 6, 6249},
+    {"7K/7p/7k/8/8/8/8/8 b - -", 6, 6249},
+    {"8/2k1p3/3pP3/3P2K1/8/8/8/8 b - -", 6, 34822},
+    {"8/8/8/8/8/4k3/4P3/4K3 w - -", 6, 11848},
+    {"4k3/4p3/4K3/8/8/8/8/8 b - -", 6, 11848},
+    {"8/8/7k/7p/7P/7K/8/8 w - -", 6, 10724},
+    {"8/8/k7/p7/P7/K7/8/8 w - -", 6, 10724},
+    {"8/8/3k4/3p4/3P4/3K4/8/8 w - -", 6, 53138},
+    {"8/3k4/3p4/8/3P4/3K4/8/8 w - -", 6, 157093},
+    {"8/8/3k4/3p4/8/3P4/3K4/8 w - -", 6, 158065},
+    {"k7/8/3p4/8/3P4/8/8/7K w - -", 6, 20960},
+    {"8/8/7k/7p/7P/7K/8/8 b - -", 6, 10724},
+    {"8/8/k7/p7/P7/K7/8/8 b - -", 6, 10724},
+    {"8/8/3k4/3p4/3P4/3K4/8/8 b - -", 6, 53138},
+    {"8/3k4/3p4/8/3P4/3K4/8/8 b - -", 6, 158065},
+    {"8/8/3k4/3p4/8/3P4/3K4/8 b - -", 6, 157093},
+    {"k7/8/3p4/8/3P4/8/8/7K b - -", 6, 21104},
+    {"7k/3p4/8/8/3P4/8/8/K7 w - -", 6, 32191},
+    {"7k/8/8/3p4/8/8/3P4/K7 w - -", 6, 30980},
+    {"k7/8/8/7p/6P1/8/8/K7 w - -", 6, 41874},
+    {"k7/8/7p/8/8/6P1/8/K7 w - -", 6, 29679},
+    {"k7/8/8/6p1/7P/8/8/K7 w - -", 6, 41874},
+    {"k7/8/6p1/8/8/7P/8/K7 w - -", 6, 29679},
+    {"k7/8/8/3p4/4p3/8/8/7K w - -", 6, 22886},
+    {"k7/8/3p4/8/8/4P3/8/7K w - -", 6, 28662},
+    {"7k/3p4/8/8/3P4/8/8/K7 b - -", 6, 32167},
+    {"7k/8/8/3p4/8/8/3P4/K7 b - -", 6, 30749},
+    {"k7/8/8/7p/6P1/8/8/K7 b - -", 6, 41874},
+    {"k7/8/7p/8/8/6P1/8/K7 b - -", 6, 29679},
+    {"k7/8/8/6p1/7P/8/8/K7 b - -", 6, 41874},
+    {"k7/8/6p1/8/8/7P/8/K7 b - -", 6, 29679},
+    {"k7/8/8/3p4/4p3/8/8/7K b - -", 6, 22579},
+    {"k7/8/3p4/8/8/4P3/8/7K b - -", 6, 28662},
+    {"7k/8/8/p7/1P6/8/8/7K w - -", 6, 41874},
+    {"7k/8/p7/8/8/1P6/8/7K w - -", 6, 29679},
+    {"7k/8/8/1p6/P7/8/8/7K w - -", 6, 41874},
+    {"7k/8/1p6/8/8/P7/8/7K w - -", 6, 29679},
+    {"k7/7p/8/8/8/8/6P1/K7 w - -", 6, 55338},
+    {"k7/6p1/8/8/8/8/7P/K7 w - -", 6, 55338},
+    {"3k4/3pp3/8/8/8/8/3PP3/3K4 w - -", 6, 199002},
+    {"7k/8/8/p7/1P6/8/8/7K b - -", 6, 41874},
+    {"7k/8/p7/8/8/1P6/8/7K b - -", 6, 29679},
+    {"7k/8/8/1p6/P7/8/8/7K b - -", 6, 41874},
+    {"7k/8/1p6/8/8/P7/8/7K b - -", 6, 29679},
+    {"k7/7p/8/8/8/8/6P1/K7 b - -", 6, 55338},
+    {"k7/6p1/8/8/8/8/7P/K7 b - -", 6, 55338},
+    {"3k4/3pp3/8/8/8/8/3PP3/3K4 b - -", 6, 199002},
+    {"8/Pk6/8/8/8/8/6Kp/8 w - -", 6, 1030499},
+    {"n1n5/1Pk5/8/8/8/8/5Kp1/5N1N w - -", 5, 2193768},
+    {"8/PPPk4/8/8/8/8/4Kppp/8 w - -", 5, 1533145},
+    {"n1n5/PPPk4/8/8/8/8/4Kppp/5N1N w - -", 4, 182838},
+    {"8/Pk6/8/8/8/8/6Kp/8 b - -", 6, 1030499},
+    {"n1n5/1Pk5/8/8/8/8/5Kp1/5N1N b - -", 5, 2193768},
+    {"8/PPPk4/8/8/8/8/4Kppp/8 b - -", 5, 1533145},
+    {"n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - -", 4, 182838},
+    {tricky_position, 4, 4085603},
+    {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -", 5, 674624},
+    {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq -", 4, 422333},
+    {"r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ -", 4, 422333},
+    {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ -", 4, 2103487},
+    {killer_position, 4, 1032012},
+    {cmk_position, 4, 1679340},
+};
+
+// run the perft suite, returns the number of positions with a wrong node count
+int perft_suite_test()
+{
+  int positions = sizeof(perft_suite) / sizeof(perft_suite[0]);
+  int failures = 0;
+
+  long total_nodes = 0;
+  int total_time = 0;
+
+  printf("\n     Perft Suite: %d positions\n\n", positions);
+
+  for (int index = 0; index < positions; index++)
+  {
+    parse_fen(perft_suite[index].fen);
+
+    // reset nodes count
+    nodes = 0;
+
+    int start = get_time_ms();
+
+    perft_driver(perft_suite[index].depth);
+
+    int time = get_time_ms() - start;
+
+    total_nodes += nodes;
+    total_time += time;
+
+    if (nodes == perft_suite[index].nodes)
+    {
+      printf("     %3d   Depth: %d   Nodes: %9ld   Time: %5d   NPS: %9ld   ok\n", index + 1, perft_suite[index].depth, nodes, time, time ? nodes * 1000 / time : 0);
+    }
+    else
+    {
+      failures++;
+      printf("     %3d   Depth: %d   Nodes: %9ld   Expected: %ld   FAILED   %s\n", index + 1, perft_suite[index].depth, nodes, perft_suite[index].nodes, perft_suite[index].fen);
+    }
+  }
+
+  printf("\n     Nodes: %ld\n", total_nodes);
+  printf("     Time: %d\n", total_time);
+  printf("     NPS: %ld\n", total_time ? total_nodes * 1000 / total_time : 0);
+  printf("     Failed: %d\n\n", failures);
+
+  return failures;
+}
+
+int main(int argc, char *argv[])
+{
+  init_all();
+
+  // batch analysis mode
+  if (argc > 2 && !strcmp(argv[1], "batch"))
+  {
+    return batch_analysis(argc - 2, argv + 2);
+  }
+
+  // self-play data generation
+  if (argc > 2 && !strcmp(argv[1], "gensfen"))
+  {
+    return gensfen(argc - 2, argv + 2);
+  }
+
+  // search benchmark (node count signature and NPS)
+  if (argc > 1 && !strcmp(argv[1], "bench"))
+  {
+    search_bench(argc > 2 ? atoi(argv[2]) : bench_depth);
+    return 0;
+  }
+
+  // batch kernel benchmark (exit code tells whether batch and scalar results match)
+  if (argc > 1 && !strcmp(argv[1], "batchbench"))
+  {
+    return batch_bench(argc > 2 ? atoi(argv[2]) : batch_bench_positions);
+  }
+
+  // perft regression suite (exit code tells whether all node counts match)
+  if (argc > 1 && !strcmp(argv[1], "perftsuite"))
+  {
+    return perft_suite_test() ? 1 : 0;
+  }
+
+  // move generator performance test on the start position
+  if (argc > 1 && !strcmp(argv[1], "perft"))
+  {
+    parse_fen(start_position);
+    print_board();
+
+    perft_test(argc > 2 ? atoi(argv[2]) : 6);
+
+    return 0;
+  }
+
+  // analysis server
+  if (argc > 2 && !strcmp(argv[1], "server"))
+  {
+    return analysis_server(argc - 2, argv + 2);
+  }
+
+  // reset STDIN & STDOUT buffers
+  setbuf(stdin, NULL);
+  setbuf(stdout, NULL);
+
+  // connect to the GUI
+  console_client.output = stdout;
+  uci_loop(stdin);
+
+  // leave the shared memory segment (the last process removes it)
+  if (hash_segment_fd >= 0)
+    detach_hash_segment();
+
+  return 0;
 }
\ No newline at end of file